@@ -0,0 +1,72 @@
+#include <atomic>
+#include <brynet/net/EventLoop.hpp>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace brynet;
+using namespace brynet::net;
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: <producer thread num> <functor num per producer>\n");
+        exit(-1);
+    }
+
+    const auto producerNum = atoi(argv[1]);
+    const auto functorNum = atoll(argv[2]);
+    const auto total = producerNum * functorNum;
+
+    auto eventLoop = std::make_shared<EventLoop>();
+    std::atomic_bool running = ATOMIC_VAR_INIT(true);
+    std::atomic_llong executed = ATOMIC_VAR_INIT(0);
+
+    std::thread ioThread([&]() {
+        while (running)
+        {
+            eventLoop->loop(100);
+        }
+    });
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> producers;
+    for (int i = 0; i < producerNum; i++)
+    {
+        producers.emplace_back([&]() {
+            for (long long j = 0; j < functorNum; j++)
+            {
+                eventLoop->runAsyncFunctor([&executed]() {
+                    executed++;
+                });
+            }
+        });
+    }
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+    while (executed < total)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    const auto cost = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - startTime);
+
+    running = false;
+    eventLoop->wakeup();
+    ioThread.join();
+
+    std::cout << "producer num:" << producerNum
+              << ", functor num:" << total
+              << ", cost:" << cost.count() / 1000 << " ms"
+              << ", " << static_cast<long long>(total * 1000000.0 / cost.count()) << " functor/s"
+              << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include <atomic>
+#include <brynet/net/AsyncConnector.hpp>
+#include <brynet/net/wrapper/ConnectionBuilder.hpp>
+#include <brynet/net/wrapper/ServiceBuilder.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <vector>
+#ifdef BRYNET_PLATFORM_LINUX
+#include <sys/resource.h>
+#endif
+
+using namespace brynet;
+using namespace brynet::net;
+
+#ifdef BRYNET_PLATFORM_LINUX
+// 在eventLoop线程中获取该线程已使用的CPU时间(秒)
+static double GetLoopThreadCpuTime(const EventLoop::Ptr& eventLoop)
+{
+    auto promise = std::make_shared<std::promise<double>>();
+    auto future = promise->get_future();
+    eventLoop->runAsyncFunctor([promise]() {
+        struct rusage usage;
+        getrusage(RUSAGE_THREAD, &usage);
+        promise->set_value(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+                           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000000.0);
+    });
+    return future.get();
+}
+#endif
+
+// 每次在loop线程中连续发送batch个短消息(模拟一个tick), 最后一个消息发送完成后再开始下一个tick
+class Ticker
+{
+public:
+    Ticker(TcpConnection::Ptr session, std::string msg, int batch, std::atomic_llong& totalSendNum)
+        : mSession(std::move(session)),
+          mMsg(std::move(msg)),
+          mBatch(batch),
+          mTotalSendNum(totalSendNum)
+    {
+    }
+
+    void start()
+    {
+        mSession->getEventLoop()->runAsyncFunctor([this]() {
+            tick();
+        });
+    }
+
+    void stop()
+    {
+        mStop = true;
+    }
+
+private:
+    void tick()
+    {
+        if (mStop)
+        {
+            return;
+        }
+        for (int i = 1; i < mBatch; i++)
+        {
+            mSession->send(mMsg);
+        }
+        mSession->send(mMsg, [this]() {
+            mTotalSendNum += mBatch;
+            // 下一个tick在本轮loop结束后执行, 不在发送完成回调中直接发送, 以免一直在flush中循环而无法处理其他任务
+            mSession->getEventLoop()->runFunctorAfterLoop([this]() {
+                tick();
+            });
+        });
+    }
+
+private:
+    const TcpConnection::Ptr mSession;
+    const std::string mMsg;
+    const int mBatch;
+    std::atomic_llong& mTotalSendNum;
+    std::atomic_bool mStop{false};
+};
+
+// 本地回环上每个连接每个tick发送大量短消息, 对比开启短消息合并前后的吞吐和服务端loop线程CPU时间
+int main(int argc, char** argv)
+{
+    if (argc != 7)
+    {
+        fprintf(stderr, "Usage: <listen port> <connection num> <msg bytes> <msgs per tick> <seconds> <coalesce 0|1>\n");
+        exit(-1);
+    }
+
+    const auto port = atoi(argv[1]);
+    const auto connectionNum = atoi(argv[2]);
+    const auto msgSize = static_cast<size_t>(atoi(argv[3]));
+    const auto batch = atoi(argv[4]);
+    const auto seconds = atoi(argv[5]);
+    const auto coalesce = atoi(argv[6]) != 0;
+
+    auto server = TcpService::Create();
+    server->startWorkerThread(1);
+
+    std::mutex sessionsGuard;
+    std::vector<TcpConnection::Ptr> serverSessions;
+    wrapper::ListenerBuilder listener;
+    listener.WithService(server)
+            .AddEnterCallback([&](const TcpConnection::Ptr& session) {
+                if (coalesce)
+                {
+                    session->setCoalesceThreshold(256);
+                }
+                std::lock_guard<std::mutex> lck(sessionsGuard);
+                serverSessions.push_back(session);
+            })
+            .WithMaxRecvBufferSize(1024)
+            .WithAddr(false, "127.0.0.1", port)
+            .asyncRun();
+
+    auto client = TcpService::Create();
+    client->startWorkerThread(2);
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+
+    std::atomic_llong totalRecvSize = ATOMIC_VAR_INIT(0);
+    std::vector<TcpConnection::Ptr> clientSessions;
+    for (int i = 0; i < connectionNum; i++)
+    {
+        wrapper::ConnectionBuilder connectionBuilder;
+        auto session = connectionBuilder.WithService(client)
+                               .WithConnector(connector)
+                               .WithTimeout(std::chrono::seconds(10))
+                               .WithAddr("127.0.0.1", port)
+                               .WithMaxRecvBufferSize(256 * 1024)
+                               .AddEnterCallback([&totalRecvSize](const TcpConnection::Ptr& session) {
+                                   session->setDataCallback([&totalRecvSize](brynet::base::BasePacketReader& reader) {
+                                       totalRecvSize += reader.size();
+                                       reader.consumeAll();
+                                   });
+                               })
+                               .syncConnect();
+        if (session == nullptr)
+        {
+            std::cerr << "connect failed" << std::endl;
+            exit(-1);
+        }
+        clientSessions.push_back(session);
+    }
+    while (true)
+    {
+        std::lock_guard<std::mutex> lck(sessionsGuard);
+        if (serverSessions.size() == static_cast<size_t>(connectionNum))
+        {
+            break;
+        }
+    }
+
+    std::atomic_llong totalSendNum = ATOMIC_VAR_INIT(0);
+    std::vector<std::unique_ptr<Ticker>> tickers;
+    for (const auto& session : serverSessions)
+    {
+        tickers.emplace_back(new Ticker(session, std::string(msgSize, 'm'), batch, totalSendNum));
+    }
+
+#ifdef BRYNET_PLATFORM_LINUX
+    const auto serverLoop = server->getEventLoops().front();
+    const auto startCpu = GetLoopThreadCpuTime(serverLoop);
+#endif
+    const auto startTime = std::chrono::steady_clock::now();
+    for (const auto& ticker : tickers)
+    {
+        ticker->start();
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    const auto sendNum = totalSendNum.load();
+#ifdef BRYNET_PLATFORM_LINUX
+    const auto cpu = GetLoopThreadCpuTime(serverLoop) - startCpu;
+#else
+    const auto cpu = 0.0;
+#endif
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    const auto million = static_cast<double>(sendNum) / 1000000;
+    std::cout << (coalesce ? "coalesce" : "no coalesce")
+              << ", sent " << million << " M msgs"
+              << ", " << million / elapsed << " M msgs/s"
+              << ", server loop cpu " << cpu << " s"
+              << ", cpu per M msgs " << (million > 0 ? cpu / million : 0) << " s"
+              << std::endl;
+
+    for (const auto& ticker : tickers)
+    {
+        ticker->stop();
+    }
+    listener.stop();
+    for (const auto& session : clientSessions)
+    {
+        session->postDisConnect();
+    }
+    connector->stopWorkerThread();
+    client->stopWorkerThread();
+    server->stopWorkerThread();
+
+    return 0;
+}
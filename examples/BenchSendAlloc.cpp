@@ -0,0 +1,135 @@
+#include <atomic>
+#include <brynet/net/AsyncConnector.hpp>
+#include <brynet/net/wrapper/ConnectionBuilder.hpp>
+#include <brynet/net/wrapper/ServiceBuilder.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <thread>
+
+using namespace brynet;
+using namespace brynet::net;
+
+// 只统计发送线程自身的堆分配次数
+static thread_local long long AllocCount = 0;
+
+void* operator new(std::size_t size)
+{
+    AllocCount++;
+    if (auto p = malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    free(p);
+}
+
+std::atomic_llong TotalRecvSize = ATOMIC_VAR_INIT(0);
+
+static void bench(const char* name,
+                  const TcpConnection::Ptr& session,
+                  const SendableMsg::Ptr& msg,
+                  long long packetNum,
+                  bool withCallback)
+{
+    const auto startRecvSize = TotalRecvSize.load();
+    const auto startAllocCount = AllocCount;
+    const auto startTime = std::chrono::steady_clock::now();
+    auto holder = std::make_shared<int>(0);
+    for (long long i = 0; i < packetNum; i++)
+    {
+        if (withCallback)
+        {
+            session->send(msg, [holder]() {
+                (*holder)++;
+            });
+        }
+        else
+        {
+            session->send(msg);
+        }
+    }
+    const auto allocCount = AllocCount - startAllocCount;
+
+    const auto expectRecvSize = startRecvSize + packetNum * static_cast<long long>(msg->size());
+    while (TotalRecvSize < expectRecvSize)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    std::cout << name << ": " << packetNum << " sends, "
+              << allocCount << " allocations, "
+              << static_cast<double>(allocCount) / packetNum << " allocations/send, "
+              << packetNum / elapsed / 1000000 << " M sends/s"
+              << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: <listen port> <packet num>\n");
+        exit(-1);
+    }
+
+    const auto port = atoi(argv[1]);
+    const auto packetNum = atoll(argv[2]);
+
+    auto service = TcpService::Create();
+    service->startWorkerThread(2);
+
+    wrapper::ListenerBuilder listener;
+    listener.WithService(service)
+            .AddEnterCallback([](const TcpConnection::Ptr& session) {
+                session->setDataCallback([](brynet::base::BasePacketReader& reader) {
+                    TotalRecvSize += reader.size();
+                    reader.consumeAll();
+                });
+            })
+            .WithMaxRecvBufferSize(1024 * 1024)
+            .WithAddr(false, "127.0.0.1", port)
+            .asyncRun();
+
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+
+    wrapper::ConnectionBuilder connectionBuilder;
+    auto session = connectionBuilder.WithService(service)
+                           .WithConnector(connector)
+                           .WithTimeout(std::chrono::seconds(10))
+                           .WithAddr("127.0.0.1", port)
+                           .WithMaxRecvBufferSize(1024)
+                           .syncConnect();
+    if (session == nullptr)
+    {
+        std::cerr << "connect failed" << std::endl;
+        exit(-1);
+    }
+    if (session->getEventLoop()->isInLoopThread())
+    {
+        std::cerr << "must send from other thread" << std::endl;
+        exit(-1);
+    }
+
+    // 复用同一个消息, 只统计投递到io线程本身的分配
+    auto msg = MakeStringMsg(std::string(64, 'a'));
+    bench("send(msg)", session, msg, packetNum, false);
+    bench("send(msg, callback)", session, msg, packetNum, true);
+
+    listener.stop();
+    connector->stopWorkerThread();
+    service->stopWorkerThread();
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <atomic>
+#include <brynet/net/AsyncConnector.hpp>
+#include <brynet/net/wrapper/ConnectionBuilder.hpp>
+#include <brynet/net/wrapper/ServiceBuilder.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace brynet;
+using namespace brynet::net;
+
+// 以读为主的负载: 客户端持续发送, 服务端每收到64个包才回复一次,
+// 统计服务端EventLoop收到的可写事件中有多少是发送队列为空的无效唤醒
+int main(int argc, char** argv)
+{
+    if (argc != 4)
+    {
+        fprintf(stderr, "Usage: <listen port> <client num> <seconds>\n");
+        exit(-1);
+    }
+
+    const auto port = atoi(argv[1]);
+    const auto clientNum = atoi(argv[2]);
+    const auto seconds = atoi(argv[3]);
+    const size_t packetLen = 256;
+
+    auto server = TcpService::Create();
+    server->startWorkerThread(1);
+
+    std::atomic_llong totalRecvSize = ATOMIC_VAR_INIT(0);
+    auto replyMsg = MakeStringMsg(std::string(16, 'r'));
+    wrapper::ListenerBuilder listener;
+    listener.WithService(server)
+            .AddEnterCallback([&totalRecvSize, replyMsg, packetLen](const TcpConnection::Ptr& session) {
+                auto recvSize = std::make_shared<size_t>(0);
+                auto rawSession = session.get();
+                session->setDataCallback([&totalRecvSize, replyMsg, packetLen, recvSize, rawSession](brynet::base::BasePacketReader& reader) {
+                    const auto len = reader.size();
+                    totalRecvSize += len;
+                    const auto before = *recvSize / (packetLen * 64);
+                    *recvSize += len;
+                    if (*recvSize / (packetLen * 64) != before)
+                    {
+                        rawSession->send(replyMsg);
+                    }
+                    reader.consumeAll();
+                });
+            })
+            .WithMaxRecvBufferSize(64 * 1024)
+            .WithAddr(false, "127.0.0.1", port)
+            .asyncRun();
+
+    auto client = TcpService::Create();
+    client->startWorkerThread(1);
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+
+    std::vector<TcpConnection::Ptr> sessions;
+    for (int i = 0; i < clientNum; i++)
+    {
+        wrapper::ConnectionBuilder connectionBuilder;
+        auto session = connectionBuilder.WithService(client)
+                               .WithConnector(connector)
+                               .WithTimeout(std::chrono::seconds(10))
+                               .WithAddr("127.0.0.1", port)
+                               .WithMaxRecvBufferSize(1024)
+                               .AddEnterCallback([](const TcpConnection::Ptr& session) {
+                                   session->setDataCallback([](brynet::base::BasePacketReader& reader) {
+                                       reader.consumeAll();
+                                   });
+                               })
+                               .syncConnect();
+        if (session == nullptr)
+        {
+            std::cerr << "connect failed" << std::endl;
+            exit(-1);
+        }
+        sessions.push_back(session);
+    }
+
+    auto msg = MakeStringMsg(std::string(packetLen, 'a'));
+    const auto startStats = server->getEventLoopStats().front();
+    const auto endTime = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    while (std::chrono::steady_clock::now() < endTime)
+    {
+        for (const auto& session : sessions)
+        {
+            session->send(msg);
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    const auto stats = server->getEventLoopStats().front();
+
+    const auto sendEvents = stats.sendEventCount - startStats.sendEventCount;
+    const auto spurious = stats.spuriousSendEventCount - startStats.spuriousSendEventCount;
+    std::cout << "recv " << totalRecvSize / 1024 << " KB"
+              << ", loop iterations:" << stats.loopCount - startStats.loopCount
+              << ", send events:" << sendEvents
+              << ", spurious send events:" << spurious
+              << ", channel updates:" << stats.channelUpdateCount - startStats.channelUpdateCount
+              << std::endl;
+
+    listener.stop();
+    connector->stopWorkerThread();
+    client->stopWorkerThread();
+    server->stopWorkerThread();
+
+    return 0;
+}
@@ -0,0 +1,196 @@
+#include <atomic>
+#include <brynet/net/AsyncConnector.hpp>
+#include <brynet/net/wrapper/ConnectionBuilder.hpp>
+#include <brynet/net/wrapper/ServiceBuilder.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <vector>
+#ifdef BRYNET_PLATFORM_LINUX
+#include <sys/resource.h>
+#endif
+
+using namespace brynet;
+using namespace brynet::net;
+
+#ifdef BRYNET_PLATFORM_LINUX
+// 在eventLoop线程中获取该线程已使用的CPU时间(秒)
+static double GetLoopThreadCpuTime(const EventLoop::Ptr& eventLoop)
+{
+    auto promise = std::make_shared<std::promise<double>>();
+    auto future = promise->get_future();
+    eventLoop->runAsyncFunctor([promise]() {
+        struct rusage usage;
+        getrusage(RUSAGE_THREAD, &usage);
+        promise->set_value(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+                           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000000.0);
+    });
+    return future.get();
+}
+
+// 持续发送同一个快照消息, 每个订阅者最多有maxInflight个消息尚未发送完成
+class Publisher
+{
+public:
+    Publisher(TcpConnection::Ptr session, SendableMsg::Ptr msg, std::atomic_llong& totalSendSize)
+        : mSession(std::move(session)),
+          mMsg(std::move(msg)),
+          mTotalSendSize(totalSendSize)
+    {
+    }
+
+    void start(int maxInflight)
+    {
+        for (int i = 0; i < maxInflight; i++)
+        {
+            sendOne();
+        }
+    }
+
+    void stop()
+    {
+        mStop = true;
+    }
+
+private:
+    void sendOne()
+    {
+        if (mStop)
+        {
+            return;
+        }
+        mSession->send(mMsg, [this]() {
+            mTotalSendSize += mMsg->size();
+            sendOne();
+        });
+    }
+
+private:
+    const TcpConnection::Ptr mSession;
+    const SendableMsg::Ptr mMsg;
+    std::atomic_llong& mTotalSendSize;
+    std::atomic_bool mStop{false};
+};
+#endif
+
+// 本地回环上向多个订阅者推送同一个大消息, 对比开启MSG_ZEROCOPY前后服务端每发送1GB消耗的CPU时间
+int main(int argc, char** argv)
+{
+    if (argc != 6)
+    {
+        fprintf(stderr, "Usage: <listen port> <subscriber num> <msg KB> <seconds> <zerocopy 0|1>\n");
+        exit(-1);
+    }
+
+#ifdef BRYNET_PLATFORM_LINUX
+    const auto port = atoi(argv[1]);
+    const auto subscriberNum = atoi(argv[2]);
+    const auto msgSize = static_cast<size_t>(atoi(argv[3])) * 1024;
+    const auto seconds = atoi(argv[4]);
+    const auto zeroCopy = atoi(argv[5]) != 0;
+
+    auto server = TcpService::Create();
+    server->startWorkerThread(1);
+
+    std::mutex sessionsGuard;
+    std::vector<TcpConnection::Ptr> serverSessions;
+    wrapper::ListenerBuilder listener;
+    listener.WithService(server)
+            .AddEnterCallback([&](const TcpConnection::Ptr& session) {
+                if (zeroCopy)
+                {
+                    session->setZeroCopyThreshold(64 * 1024);
+                }
+                std::lock_guard<std::mutex> lck(sessionsGuard);
+                serverSessions.push_back(session);
+            })
+            .WithMaxRecvBufferSize(1024)
+            .WithAddr(false, "127.0.0.1", port)
+            .asyncRun();
+
+    auto client = TcpService::Create();
+    client->startWorkerThread(2);
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+
+    std::atomic_llong totalRecvSize = ATOMIC_VAR_INIT(0);
+    std::vector<TcpConnection::Ptr> clientSessions;
+    for (int i = 0; i < subscriberNum; i++)
+    {
+        wrapper::ConnectionBuilder connectionBuilder;
+        auto session = connectionBuilder.WithService(client)
+                               .WithConnector(connector)
+                               .WithTimeout(std::chrono::seconds(10))
+                               .WithAddr("127.0.0.1", port)
+                               .WithMaxRecvBufferSize(256 * 1024)
+                               .AddEnterCallback([&totalRecvSize](const TcpConnection::Ptr& session) {
+                                   session->setDataCallback([&totalRecvSize](brynet::base::BasePacketReader& reader) {
+                                       totalRecvSize += reader.size();
+                                       reader.consumeAll();
+                                   });
+                               })
+                               .syncConnect();
+        if (session == nullptr)
+        {
+            std::cerr << "connect failed" << std::endl;
+            exit(-1);
+        }
+        clientSessions.push_back(session);
+    }
+    while (true)
+    {
+        std::lock_guard<std::mutex> lck(sessionsGuard);
+        if (serverSessions.size() == static_cast<size_t>(subscriberNum))
+        {
+            break;
+        }
+    }
+
+    const auto serverLoop = server->getEventLoops().front();
+    auto snapshot = MakeStringMsg(std::string(msgSize, 's'));
+    std::atomic_llong totalSendSize = ATOMIC_VAR_INIT(0);
+    std::vector<std::unique_ptr<Publisher>> publishers;
+    for (const auto& session : serverSessions)
+    {
+        publishers.emplace_back(new Publisher(session, snapshot, totalSendSize));
+    }
+
+    const auto startCpu = GetLoopThreadCpuTime(serverLoop);
+    const auto startTime = std::chrono::steady_clock::now();
+    for (const auto& publisher : publishers)
+    {
+        publisher->start(4);
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    const auto sendSize = totalSendSize.load();
+    const auto cpu = GetLoopThreadCpuTime(serverLoop) - startCpu;
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    const auto gb = static_cast<double>(sendSize) / (1024 * 1024 * 1024);
+    std::cout << (zeroCopy ? "zerocopy" : "copy")
+              << ", sent " << gb << " GB"
+              << ", " << gb / elapsed << " GB/s"
+              << ", server loop cpu " << cpu << " s"
+              << ", cpu per GB " << (gb > 0 ? cpu / gb : 0) << " s"
+              << std::endl;
+
+    for (const auto& publisher : publishers)
+    {
+        publisher->stop();
+    }
+    listener.stop();
+    for (const auto& session : clientSessions)
+    {
+        session->postDisConnect();
+    }
+    connector->stopWorkerThread();
+    client->stopWorkerThread();
+    server->stopWorkerThread();
+#else
+    std::cerr << "MSG_ZEROCOPY is only supported on linux" << std::endl;
+#endif
+
+    return 0;
+}
@@ -68,6 +68,14 @@ int main(int argc, char** argv)
         }
 
         std::cout << "packet num:" << total_packet_num << std::endl;
+        const auto loopStats = service->getEventLoopStats();
+        for (size_t i = 0; i < loopStats.size(); i++)
+        {
+            std::cout << "loop " << i
+                      << " utilization:" << loopStats[i].utilization() * 100 << "%"
+                      << ", p99 iteration latency:" << loopStats[i].iterationLatency.percentile(99) / 1000 << " us"
+                      << std::endl;
+        }
         total_packet_num = 0;
         TotalRecvSize = 0;
 
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <brynet/base/Platform.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <vector>
+
+#ifdef BRYNET_PLATFORM_WINDOWS
+#include <windows.h>
+#elif defined BRYNET_PLATFORM_LINUX
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace brynet { namespace base {
+
+class CpuInfo final
+{
+public:
+    int cpu = 0;
+    // 所属NUMA节点, 无法获取时为0
+    int numaNode = 0;
+};
+
+// 当前进程可以使用的CPU及其NUMA节点, 按cpu编号排序
+inline std::vector<CpuInfo> GetCpuLayout()
+{
+    std::vector<CpuInfo> result;
+#ifdef BRYNET_PLATFORM_LINUX
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            if (!CPU_ISSET(cpu, &cpuSet))
+            {
+                continue;
+            }
+
+            CpuInfo info;
+            info.cpu = cpu;
+
+            char path[64];
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+            if (auto dir = opendir(path))
+            {
+                while (auto entry = readdir(dir))
+                {
+                    if (strncmp(entry->d_name, "node", 4) == 0 &&
+                        entry->d_name[4] >= '0' && entry->d_name[4] <= '9')
+                    {
+                        info.numaNode = atoi(entry->d_name + 4);
+                        break;
+                    }
+                }
+                closedir(dir);
+            }
+            result.push_back(info);
+        }
+    }
+#endif
+    if (result.empty())
+    {
+        const auto cpuNum = std::thread::hardware_concurrency();
+        for (unsigned int cpu = 0; cpu < cpuNum; cpu++)
+        {
+            CpuInfo info;
+            info.cpu = static_cast<int>(cpu);
+            result.push_back(info);
+        }
+    }
+
+    return result;
+}
+
+// 把threadNum个线程分别绑定到一个CPU上, 在NUMA节点之间轮流分配, CPU不足时循环使用
+inline std::vector<std::vector<int>> MakeSpreadCpuSets(size_t threadNum)
+{
+    std::map<int, std::vector<int>> nodeCpus;
+    for (const auto& info : GetCpuLayout())
+    {
+        nodeCpus[info.numaNode].push_back(info.cpu);
+    }
+
+    std::vector<std::vector<int>> result;
+    if (nodeCpus.empty())
+    {
+        return result;
+    }
+
+    size_t round = 0;
+    while (result.size() < threadNum)
+    {
+        bool added = false;
+        for (const auto& node : nodeCpus)
+        {
+            if (result.size() >= threadNum)
+            {
+                break;
+            }
+            if (round < node.second.size())
+            {
+                result.push_back({node.second[round]});
+                added = true;
+            }
+        }
+        round = added ? round + 1 : 0;
+    }
+
+    return result;
+}
+
+// 把当前线程绑定到cpus中的CPU上(Darwin不支持, 返回false)
+inline bool SetCurrentThreadAffinity(const std::vector<int>& cpus)
+{
+    if (cpus.empty())
+    {
+        return false;
+    }
+
+#ifdef BRYNET_PLATFORM_LINUX
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (const auto cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#elif defined BRYNET_PLATFORM_WINDOWS
+    DWORD_PTR mask = 0;
+    for (const auto cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < static_cast<int>(sizeof(mask) * 8))
+        {
+            mask |= static_cast<DWORD_PTR>(1) << cpu;
+        }
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+    return false;
+#endif
+}
+
+// 返回cpu所属的NUMA节点, 无法获取时返回0
+inline int GetCpuNumaNode(int cpu)
+{
+    for (const auto& info : GetCpuLayout())
+    {
+        if (info.cpu == cpu)
+        {
+            return info.numaNode;
+        }
+    }
+    return 0;
+}
+
+}}// namespace brynet::base
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <brynet/base/NonCopyable.hpp>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace brynet { namespace base {
+
+// HDR风格的对数-线性直方图: 每个2的幂区间再均分为2^sSubBucketBits个桶, 相对误差不超过1/8.
+// 只允许一个线程record, 其他线程可以随时snapshot(计数使用relaxed原子变量, 不需要加锁)
+class Histogram final : public NonCopyable
+{
+public:
+    static const size_t sSubBucketBits = 3;
+    static const size_t sSubBucketNum = static_cast<size_t>(1) << sSubBucketBits;
+    // 超过2^sMaxValueBits的值计入最后一个桶
+    static const size_t sMaxValueBits = 48;
+    static const size_t sBucketNum = (sMaxValueBits - sSubBucketBits + 1) * sSubBucketNum;
+
+    class Snapshot
+    {
+    public:
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+        std::array<uint64_t, sBucketNum> buckets{};
+
+        double mean() const
+        {
+            return count == 0 ? 0 : static_cast<double>(sum) / static_cast<double>(count);
+        }
+
+        // percentile取值范围为[0, 100], 返回所在桶的上界
+        uint64_t percentile(double percentile) const
+        {
+            if (count == 0)
+            {
+                return 0;
+            }
+
+            auto target = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(count) + 0.5);
+            if (target == 0)
+            {
+                target = 1;
+            }
+
+            uint64_t seen = 0;
+            for (size_t i = 0; i < buckets.size(); i++)
+            {
+                seen += buckets[i];
+                if (seen >= target)
+                {
+                    const auto upper = bucketUpperBound(i);
+                    return upper < max ? upper : max;
+                }
+            }
+            return max;
+        }
+    };
+
+    Histogram() = default;
+
+    void record(uint64_t value)
+    {
+        increase(mBuckets[bucketIndex(value)], 1);
+        increase(mCount, 1);
+        increase(mSum, value);
+        if (value > mMax.load(std::memory_order_relaxed))
+        {
+            mMax.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    Snapshot snapshot() const
+    {
+        Snapshot result;
+        for (size_t i = 0; i < mBuckets.size(); i++)
+        {
+            result.buckets[i] = mBuckets[i].load(std::memory_order_relaxed);
+        }
+        result.count = mCount.load(std::memory_order_relaxed);
+        result.sum = mSum.load(std::memory_order_relaxed);
+        result.max = mMax.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    static size_t bucketIndex(uint64_t value)
+    {
+        if (value < sSubBucketNum)
+        {
+            return static_cast<size_t>(value);
+        }
+
+        const auto msb = mostSignificantBit(value);
+        if (msb >= sMaxValueBits)
+        {
+            return sBucketNum - 1;
+        }
+
+        const auto shift = msb - sSubBucketBits;
+        return ((shift + 1) << sSubBucketBits) +
+               static_cast<size_t>((value >> shift) & (sSubBucketNum - 1));
+    }
+
+    static uint64_t bucketUpperBound(size_t index)
+    {
+        if (index < sSubBucketNum)
+        {
+            return index;
+        }
+
+        const auto shift = (index >> sSubBucketBits) - 1;
+        const auto sub = (index & (sSubBucketNum - 1)) | sSubBucketNum;
+        return ((static_cast<uint64_t>(sub) + 1) << shift) - 1;
+    }
+
+private:
+    // 单写者, 不需要原子的读-改-写指令
+    static void increase(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static size_t mostSignificantBit(uint64_t value)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return index;
+#else
+        return 63 - static_cast<size_t>(__builtin_clzll(value));
+#endif
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, sBucketNum> mBuckets{};
+    std::atomic<uint64_t> mCount{0};
+    std::atomic<uint64_t> mSum{0};
+    std::atomic<uint64_t> mMax{0};
+};
+
+}}// namespace brynet::base
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <brynet/base/NonCopyable.hpp>
+#include <cstddef>
+#include <utility>
+
+namespace brynet { namespace base {
+
+// 无锁多生产者单消费者队列(intrusive node, Dmitry Vyukov)
+// push可在任意线程调用, pop/popAll/empty只能在唯一的消费者线程调用
+template<typename T>
+class MPSCQueue final : public NonCopyable
+{
+public:
+    MPSCQueue()
+    {
+        auto stub = new Node();
+        mHead.store(stub, std::memory_order_relaxed);
+        mTail = stub;
+    }
+
+    ~MPSCQueue()
+    {
+        T value;
+        while (pop(value))
+        {
+        }
+        delete mTail;
+    }
+
+    void push(T&& value)
+    {
+        auto node = new Node(std::move(value));
+        auto prev = mHead.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    bool pop(T& value)
+    {
+        auto tail = mTail;
+        auto next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr)
+        {
+            return false;
+        }
+
+        value = std::move(next->value);
+        mTail = next;
+        delete tail;
+        return true;
+    }
+
+    // 只消费调用时刻之前已投递的元素, 之后投递的元素留给下一次调用. 返回消费数量
+    template<typename F>
+    size_t popAll(F&& f)
+    {
+        const auto last = mHead.load(std::memory_order_acquire);
+        size_t count = 0;
+        while (mTail != last)
+        {
+            T value;
+            if (!pop(value))
+            {
+                // 生产者已交换head但尚未链接next, 剩余元素下次再处理
+                break;
+            }
+            f(value);
+            ++count;
+        }
+
+        return count;
+    }
+
+    bool empty() const
+    {
+        return mTail->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node
+    {
+        Node()
+            : next(nullptr)
+        {}
+
+        explicit Node(T&& v)
+            : next(nullptr),
+              value(std::move(v))
+        {}
+
+        std::atomic<Node*> next;
+        T value;
+    };
+
+    // 生产者与消费者各自修改的指针放在不同的cache line, 避免伪共享
+    std::atomic<Node*> mHead;
+    char mPadding[64 - sizeof(std::atomic<Node*>)];
+    Node* mTail;
+};
+
+}}// namespace brynet::base
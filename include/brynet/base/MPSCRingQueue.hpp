@@ -0,0 +1,195 @@
+#pragma once
+
+#include <atomic>
+#include <brynet/base/NonCopyable.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace brynet { namespace base {
+
+// 有界环形无锁多生产者单消费者队列(Dmitry Vyukov bounded queue), 入队不分配内存.
+// 环满时转入加锁的溢出队列, 溢出期间投递的元素全部进入溢出队列, 保证同一生产者的先后顺序.
+// push可在任意线程调用, popAll/empty只能在唯一的消费者线程调用
+template<typename T>
+class MPSCRingQueue final : public NonCopyable
+{
+public:
+    // capacity会向上取整为2的幂
+    explicit MPSCRingQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size *= 2;
+        }
+        mMask = size - 1;
+        mCells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++)
+        {
+            mCells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mEnqueuePos.store(0, std::memory_order_relaxed);
+        mDequeuePos = 0;
+        mOverflow.store(false, std::memory_order_relaxed);
+    }
+
+    void push(T&& value)
+    {
+        if (!mOverflow.load(std::memory_order_acquire) && tryPush(value))
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lck(mOverflowGuard);
+        mOverflow.store(true, std::memory_order_release);
+        mOverflowValues.emplace_back(std::move(value));
+    }
+
+    // 只消费调用时刻之前已投递的元素, 之后投递的元素留给下一次调用. 返回消费数量
+    template<typename F>
+    size_t popAll(F&& f)
+    {
+        if (mOverflow.load(std::memory_order_acquire))
+        {
+            return popAllWithOverflow(f);
+        }
+
+        const auto end = mEnqueuePos.load(std::memory_order_acquire);
+        size_t count = 0;
+        while (mDequeuePos != end)
+        {
+            T value;
+            if (!tryPop(value))
+            {
+                // 生产者已占用位置但尚未写入完成, 剩余元素下次再处理
+                break;
+            }
+            f(value);
+            ++count;
+        }
+
+        return count;
+    }
+
+    bool empty() const
+    {
+        if (mOverflow.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        const auto& cell = mCells[mDequeuePos & mMask];
+        return cell.sequence.load(std::memory_order_acquire) != mDequeuePos + 1;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    bool tryPush(T& value)
+    {
+        auto pos = mEnqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;)
+        {
+            cell = &mCells[pos & mMask];
+            const auto seq = cell->sequence.load(std::memory_order_acquire);
+            const auto dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (dif == 0)
+            {
+                if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (dif < 0)
+            {
+                // 环已满
+                return false;
+            }
+            else
+            {
+                pos = mEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value)
+    {
+        auto& cell = mCells[mDequeuePos & mMask];
+        if (cell.sequence.load(std::memory_order_acquire) != mDequeuePos + 1)
+        {
+            return false;
+        }
+
+        // 先取出再归还位置, 处理元素期间生产者即可复用该位置
+        value = std::move(cell.value);
+        cell.sequence.store(mDequeuePos + mMask + 1, std::memory_order_release);
+        ++mDequeuePos;
+        return true;
+    }
+
+    // 溢出期间生产者的环中元素都早于其溢出元素: 持锁取出溢出队列时记下环中已占用的位置,
+    // 先处理完这些位置再处理溢出元素
+    template<typename F>
+    size_t popAllWithOverflow(F& f)
+    {
+        size_t end;
+        {
+            std::lock_guard<std::mutex> lck(mOverflowGuard);
+            end = mEnqueuePos.load(std::memory_order_acquire);
+            mPopValues.swap(mOverflowValues);
+            mOverflow.store(false, std::memory_order_release);
+        }
+
+        size_t count = 0;
+        while (mDequeuePos != end)
+        {
+            T value;
+            if (!tryPop(value))
+            {
+                // 等待已占用位置的生产者写入完成
+                std::this_thread::yield();
+                continue;
+            }
+            f(value);
+            ++count;
+        }
+        for (auto& value : mPopValues)
+        {
+            f(value);
+        }
+        count += mPopValues.size();
+        mPopValues.clear();
+        return count;
+    }
+
+private:
+    std::unique_ptr<Cell[]> mCells;
+    size_t mMask;
+
+    // 生产者与消费者各自修改的位置放在不同的cache line, 避免伪共享
+    char mPadding0[64];
+    std::atomic<size_t> mEnqueuePos;
+    char mPadding1[64 - sizeof(std::atomic<size_t>)];
+    size_t mDequeuePos;
+
+    std::atomic_bool mOverflow;
+    std::mutex mOverflowGuard;
+    std::vector<T> mOverflowValues;
+    // 只在消费者线程使用
+    std::vector<T> mPopValues;
+};
+
+}}// namespace brynet::base
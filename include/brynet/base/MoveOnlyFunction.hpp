@@ -0,0 +1,256 @@
+#pragma once
+
+#include <brynet/base/Noexcept.hpp>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace brynet { namespace base {
+
+template<typename Signature, size_t InlineSize = 56>
+class MoveOnlyFunction;
+
+// 只能移动的std::function替代品, 不超过InlineSize字节且可无异常移动的可调用对象直接存放在对象内部,
+// 避免每次投递lambda时的堆分配. 更大(或对齐要求超过指针)的可调用对象仍然在堆上分配.
+// 默认InlineSize为56, 加上操作表指针正好64字节
+template<typename R, typename... Args, size_t InlineSize>
+class MoveOnlyFunction<R(Args...), InlineSize>
+{
+    static_assert(InlineSize >= sizeof(void*), "InlineSize must be able to hold a pointer");
+
+public:
+    MoveOnlyFunction() BRYNET_NOEXCEPT
+        : mOps(nullptr)
+    {
+    }
+
+    MoveOnlyFunction(std::nullptr_t) BRYNET_NOEXCEPT
+        : mOps(nullptr)
+    {
+    }
+
+    template<typename F,
+             typename = typename std::enable_if<
+                     !std::is_same<typename std::decay<F>::type, MoveOnlyFunction>::value>::type>
+    MoveOnlyFunction(F&& f)
+        : mOps(nullptr)
+    {
+        using Functor = typename std::decay<F>::type;
+        if (isNull(f))
+        {
+            return;
+        }
+
+        construct<Functor>(std::forward<F>(f), std::integral_constant<bool, isInline<Functor>()>());
+    }
+
+    // 移动操作必须是noexcept, 否则包含MoveOnlyFunction的可调用对象无法内联存放
+    MoveOnlyFunction(MoveOnlyFunction&& other) noexcept
+        : mOps(other.mOps)
+    {
+        if (mOps != nullptr)
+        {
+            mOps->move(&other.mStorage, &mStorage);
+            other.mOps = nullptr;
+        }
+    }
+
+    MoveOnlyFunction(const MoveOnlyFunction&) = delete;
+    MoveOnlyFunction& operator=(const MoveOnlyFunction&) = delete;
+
+    ~MoveOnlyFunction()
+    {
+        reset();
+    }
+
+    MoveOnlyFunction& operator=(MoveOnlyFunction&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            if (other.mOps != nullptr)
+            {
+                other.mOps->move(&other.mStorage, &mStorage);
+                mOps = other.mOps;
+                other.mOps = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    MoveOnlyFunction& operator=(std::nullptr_t) BRYNET_NOEXCEPT
+    {
+        reset();
+        return *this;
+    }
+
+    template<typename F,
+             typename = typename std::enable_if<
+                     !std::is_same<typename std::decay<F>::type, MoveOnlyFunction>::value>::type>
+    MoveOnlyFunction& operator=(F&& f)
+    {
+        return *this = MoveOnlyFunction(std::forward<F>(f));
+    }
+
+    R operator()(Args... args) const
+    {
+        if (mOps == nullptr)
+        {
+            throw std::bad_function_call();
+        }
+        return mOps->invoke(&mStorage, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const BRYNET_NOEXCEPT
+    {
+        return mOps != nullptr;
+    }
+
+    // 可调用对象是否存放在对象内部(未发生堆分配)
+    bool isInlineStored() const BRYNET_NOEXCEPT
+    {
+        return mOps != nullptr && mOps->isInline;
+    }
+
+    friend bool operator==(const MoveOnlyFunction& f, std::nullptr_t) BRYNET_NOEXCEPT
+    {
+        return !f;
+    }
+
+    friend bool operator==(std::nullptr_t, const MoveOnlyFunction& f) BRYNET_NOEXCEPT
+    {
+        return !f;
+    }
+
+    friend bool operator!=(const MoveOnlyFunction& f, std::nullptr_t) BRYNET_NOEXCEPT
+    {
+        return static_cast<bool>(f);
+    }
+
+    friend bool operator!=(std::nullptr_t, const MoveOnlyFunction& f) BRYNET_NOEXCEPT
+    {
+        return static_cast<bool>(f);
+    }
+
+private:
+    using Storage = typename std::aligned_storage<InlineSize, alignof(void*)>::type;
+
+    struct Ops
+    {
+        R (*invoke)(Storage* storage, Args&&... args);
+        void (*move)(Storage* from, Storage* to);
+        void (*destroy)(Storage* storage);
+        bool isInline;
+    };
+
+    template<typename Functor>
+    static constexpr bool isInline()
+    {
+        return sizeof(Functor) <= sizeof(Storage) &&
+               alignof(Functor) <= alignof(Storage) &&
+               std::is_nothrow_move_constructible<Functor>::value;
+    }
+
+    template<typename F>
+    static bool isNull(const F&)
+    {
+        return false;
+    }
+
+    template<typename T>
+    static bool isNull(T* f)
+    {
+        return f == nullptr;
+    }
+
+    template<typename Sig>
+    static bool isNull(const std::function<Sig>& f)
+    {
+        return !f;
+    }
+
+    template<typename Functor, typename F>
+    void construct(F&& f, std::true_type)
+    {
+        ::new (static_cast<void*>(&mStorage)) Functor(std::forward<F>(f));
+        static const Ops ops = {
+                &invokeInline<Functor>,
+                &moveInline<Functor>,
+                &destroyInline<Functor>,
+                true};
+        mOps = &ops;
+    }
+
+    template<typename Functor, typename F>
+    void construct(F&& f, std::false_type)
+    {
+        heapPtr<Functor>(&mStorage) = new Functor(std::forward<F>(f));
+        static const Ops ops = {
+                &invokeHeap<Functor>,
+                &moveHeap<Functor>,
+                &destroyHeap<Functor>,
+                false};
+        mOps = &ops;
+    }
+
+    template<typename Functor>
+    static R invokeInline(Storage* storage, Args&&... args)
+    {
+        return (*reinterpret_cast<Functor*>(storage))(std::forward<Args>(args)...);
+    }
+
+    template<typename Functor>
+    static void moveInline(Storage* from, Storage* to)
+    {
+        auto functor = reinterpret_cast<Functor*>(from);
+        ::new (static_cast<void*>(to)) Functor(std::move(*functor));
+        functor->~Functor();
+    }
+
+    template<typename Functor>
+    static void destroyInline(Storage* storage)
+    {
+        reinterpret_cast<Functor*>(storage)->~Functor();
+    }
+
+    template<typename Functor>
+    static Functor*& heapPtr(Storage* storage)
+    {
+        return *reinterpret_cast<Functor**>(storage);
+    }
+
+    template<typename Functor>
+    static R invokeHeap(Storage* storage, Args&&... args)
+    {
+        return (*heapPtr<Functor>(storage))(std::forward<Args>(args)...);
+    }
+
+    template<typename Functor>
+    static void moveHeap(Storage* from, Storage* to)
+    {
+        heapPtr<Functor>(to) = heapPtr<Functor>(from);
+    }
+
+    template<typename Functor>
+    static void destroyHeap(Storage* storage)
+    {
+        delete heapPtr<Functor>(storage);
+    }
+
+    void reset() BRYNET_NOEXCEPT
+    {
+        if (mOps != nullptr)
+        {
+            mOps->destroy(&mStorage);
+            mOps = nullptr;
+        }
+    }
+
+private:
+    mutable Storage mStorage;
+    const Ops* mOps;
+};
+
+}}// namespace brynet::base
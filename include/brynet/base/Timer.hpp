@@ -1,23 +1,29 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <brynet/base/MoveOnlyFunction.hpp>
 #include <brynet/base/Noexcept.hpp>
 #include <chrono>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <thread>
 #include <vector>
 
 namespace brynet { namespace base {
 
 class TimerMgr;
 
-class Timer final
+class Timer final : public std::enable_shared_from_this<Timer>
 {
 public:
     using Ptr = std::shared_ptr<Timer>;
     using WeakPtr = std::weak_ptr<Timer>;
-    using Callback = std::function<void(void)>;
+    using Callback = brynet::base::MoveOnlyFunction<void(void)>;
 
     Timer(std::chrono::steady_clock::time_point startTime,
           std::chrono::nanoseconds lastTime,
@@ -44,12 +50,9 @@ public:
         return getLastTime() - (now - getStartTime());
     }
 
-    void cancel()
-    {
-        std::call_once(mExecuteOnceFlag, [this]() {
-            mCallback = nullptr;
-        });
-    }
+    // 时间轮模式下, 在TimerMgr所在线程调用时会立即从时间轮中移除,
+    // 其他线程调用时通过TimerMgr::setCancelPoster投递移除操作
+    inline void cancel();
 
 private:
     void operator()()
@@ -72,6 +75,13 @@ private:
     const std::chrono::steady_clock::time_point mStartTime;
     const std::chrono::nanoseconds mLastTime;
 
+    // 时间轮模式下使用的侵入式链表节点, 链接期间由mWheelHold持有自身
+    std::atomic<TimerMgr*> mOwner{nullptr};
+    Timer* mWheelNext = nullptr;
+    Timer** mWheelPPrev = nullptr;
+    Ptr mWheelHold;
+    uint64_t mExpireTick = 0;
+
     friend class TimerMgr;
 };
 
@@ -80,6 +90,35 @@ class TimerMgr final
 public:
     using Ptr = std::shared_ptr<TimerMgr>;
 
+    enum class Mode
+    {
+        Heap,
+        // 分层哈希时间轮, 精度为1毫秒, 插入与取消均为O(1).
+        // 时长不足1毫秒的定时器仍使用最小堆, 避免被取整到下一个刻度
+        Wheel,
+    };
+
+    using Poster = std::function<void(Timer::Callback&&)>;
+
+    TimerMgr()
+        : TimerMgr(Mode::Heap)
+    {
+    }
+
+    explicit TimerMgr(Mode mode)
+        : mMode(mode),
+          mWheelBaseTime(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~TimerMgr()
+    {
+        clear();
+    }
+
+    TimerMgr(const TimerMgr&) = delete;
+    TimerMgr& operator=(const TimerMgr&) = delete;
+
     template<typename F, typename... TArgs>
     Timer::WeakPtr addTimer(
             std::chrono::nanoseconds timeout,
@@ -90,18 +129,37 @@ public:
                 std::chrono::steady_clock::now(),
                 std::chrono::nanoseconds(timeout),
                 std::bind(std::forward<F>(callback), std::forward<TArgs>(args)...));
-        mTimers.push(timer);
+        addTimer(timer);
 
         return timer;
     }
 
+    // 时间轮模式下其他线程取消定时器时, 通过poster把移除操作投递到调用schedule的线程(例如EventLoop::runAsyncFunctor).
+    // 未设置时只清除回调, 定时器到期后才从时间轮中移除. 必须在添加定时器之前设置
+    void setCancelPoster(Poster poster)
+    {
+        mCancelPoster = std::move(poster);
+    }
+
     void addTimer(const Timer::Ptr& timer)
     {
-        mTimers.push(timer);
+        if (mMode == Mode::Wheel && timer->getLastTime() >= wheelTick())
+        {
+            wheelAdd(timer);
+        }
+        else
+        {
+            mTimers.push(timer);
+        }
     }
 
     void schedule()
     {
+        if (mMode == Mode::Wheel)
+        {
+            wheelSchedule();
+        }
+
         while (!mTimers.empty())
         {
             auto tmp = mTimers.top();
@@ -117,23 +175,36 @@ public:
 
     bool isEmpty() const
     {
-        return mTimers.empty();
+        return mTimers.empty() && mWheelTimerNum == 0;
     }
 
     // if timer empty, return zero
     std::chrono::nanoseconds nearLeftTime() const
     {
-        if (mTimers.empty())
+        if (isEmpty())
         {
             return std::chrono::nanoseconds::zero();
         }
 
-        auto result = mTimers.top()->getLeftTime();
+        const auto result = nearExpireTime() - std::chrono::steady_clock::now();
         if (result < std::chrono::nanoseconds::zero())
         {
             return std::chrono::nanoseconds::zero();
         }
 
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(result);
+    }
+
+    // 最近需要调用schedule的时间点, 定时器为空时返回time_point::max()
+    std::chrono::steady_clock::time_point nearExpireTime() const
+    {
+        auto result = wheelNearExpireTime();
+        if (!mTimers.empty())
+        {
+            const auto& timer = mTimers.top();
+            result = std::min(result, timer->getStartTime() + timer->getLastTime());
+        }
+
         return result;
     }
 
@@ -143,6 +214,227 @@ public:
         {
             mTimers.pop();
         }
+
+        for (auto& level : mWheel)
+        {
+            for (auto& slot : level)
+            {
+                while (slot != nullptr)
+                {
+                    wheelUnlink(slot);
+                }
+            }
+        }
+    }
+
+private:
+    static const size_t sWheelLevelNum = 4;
+    static const size_t sWheelSlotBits = 8;
+    static const size_t sWheelSlotNum = 1 << sWheelSlotBits;
+    static const uint64_t sWheelSlotMask = sWheelSlotNum - 1;
+
+    static std::chrono::nanoseconds wheelTick()
+    {
+        return std::chrono::milliseconds(1);
+    }
+
+    uint64_t wheelNowTick() const
+    {
+        return static_cast<uint64_t>((std::chrono::steady_clock::now() - mWheelBaseTime) / wheelTick());
+    }
+
+    void wheelAdd(const Timer::Ptr& timer)
+    {
+        const auto expire = (timer->getStartTime() + timer->getLastTime()) - mWheelBaseTime;
+        // 向上取整, 保证定时器不会提前触发
+        auto expireTick = expire.count() <= 0
+                                  ? 0
+                                  : static_cast<uint64_t>((expire - std::chrono::nanoseconds(1)) / wheelTick()) + 1;
+        if (mWheelTimerNum == 0)
+        {
+            mCurrentTick = std::max<uint64_t>(mCurrentTick, wheelNowTick());
+        }
+
+        timer->mExpireTick = expireTick;
+        timer->mWheelHold = timer;
+        timer->mOwner.store(this, std::memory_order_release);
+        wheelLink(timer.get());
+        mWheelTimerNum++;
+    }
+
+    void wheelLink(Timer* timer)
+    {
+        const auto expireTick = std::max(timer->mExpireTick, mCurrentTick);
+        const auto delta = expireTick - mCurrentTick;
+
+        size_t level = 0;
+        while (level + 1 < sWheelLevelNum &&
+               delta >= (static_cast<uint64_t>(1) << ((level + 1) * sWheelSlotBits)))
+        {
+            level++;
+        }
+
+        uint64_t index;
+        if (level + 1 == sWheelLevelNum &&
+            delta >= (static_cast<uint64_t>(1) << (sWheelLevelNum * sWheelSlotBits)))
+        {
+            // 超出时间轮范围, 放在最高层的最远槽位, 级联时再重新计算
+            index = (mCurrentTick >> (level * sWheelSlotBits)) - 1;
+        }
+        else
+        {
+            index = expireTick >> (level * sWheelSlotBits);
+        }
+
+        auto& head = mWheel[level][index & sWheelSlotMask];
+        timer->mWheelNext = head;
+        if (head != nullptr)
+        {
+            head->mWheelPPrev = &timer->mWheelNext;
+        }
+        head = timer;
+        timer->mWheelPPrev = &head;
+    }
+
+    // 从槽位链表中摘除, 返回摘除前对自身的持有
+    Timer::Ptr wheelUnlink(Timer* timer)
+    {
+        if (timer->mWheelPPrev == nullptr)
+        {
+            return nullptr;
+        }
+
+        *timer->mWheelPPrev = timer->mWheelNext;
+        if (timer->mWheelNext != nullptr)
+        {
+            timer->mWheelNext->mWheelPPrev = timer->mWheelPPrev;
+        }
+        timer->mWheelNext = nullptr;
+        timer->mWheelPPrev = nullptr;
+        timer->mOwner.store(nullptr, std::memory_order_release);
+        mWheelTimerNum--;
+
+        return std::move(timer->mWheelHold);
+    }
+
+    // 把高层槽位中的定时器重新分配到低层, 返回该层的槽位索引
+    size_t wheelCascade(size_t level)
+    {
+        const auto index = (mCurrentTick >> (level * sWheelSlotBits)) & sWheelSlotMask;
+        auto timer = mWheel[level][index];
+        mWheel[level][index] = nullptr;
+        while (timer != nullptr)
+        {
+            auto next = timer->mWheelNext;
+            wheelLink(timer);
+            timer = next;
+        }
+
+        return static_cast<size_t>(index);
+    }
+
+    void wheelSchedule()
+    {
+        mWheelOwnerThread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+        const auto nowTick = wheelNowTick();
+        if (mWheelTimerNum == 0)
+        {
+            mCurrentTick = std::max(mCurrentTick, nowTick);
+            return;
+        }
+
+        while (mCurrentTick <= nowTick && mWheelTimerNum > 0)
+        {
+            const auto index = mCurrentTick & sWheelSlotMask;
+            if (index == 0)
+            {
+                for (size_t level = 1; level < sWheelLevelNum && wheelCascade(level) == 0; level++)
+                {
+                }
+            }
+            mCurrentTick++;
+
+            auto& head = mWheel[0][index];
+            while (head != nullptr)
+            {
+                auto timer = wheelUnlink(head);
+                (*timer)();
+            }
+        }
+
+        if (mWheelTimerNum == 0)
+        {
+            mCurrentTick = std::max(mCurrentTick, nowTick);
+        }
+    }
+
+    std::chrono::steady_clock::time_point wheelNearExpireTime() const
+    {
+        if (mWheelTimerNum == 0)
+        {
+            return std::chrono::steady_clock::time_point::max();
+        }
+
+        // 第0层的槽位对应未来sWheelSlotNum个刻度, 直接找到最近的非空槽位.
+        // 高层槽位中的定时器不会早于该槽位的级联时刻到期, 取最近的级联时刻,
+        // 因此返回值不晚于任何定时器的到期时间, 只有高层定时器时也不会错过级联
+        auto nearTick = std::numeric_limits<uint64_t>::max();
+        for (auto tick = mCurrentTick; tick < mCurrentTick + sWheelSlotNum; tick++)
+        {
+            if (mWheel[0][tick & sWheelSlotMask] != nullptr)
+            {
+                nearTick = tick;
+                break;
+            }
+        }
+
+        for (size_t level = 1; level < sWheelLevelNum; level++)
+        {
+            const auto shift = level * sWheelSlotBits;
+            const auto current = mCurrentTick >> shift;
+            for (auto pos = current + 1; pos <= current + sWheelSlotNum; pos++)
+            {
+                const auto cascadeTick = pos << shift;
+                if (cascadeTick >= nearTick)
+                {
+                    break;
+                }
+                if (mWheel[level][pos & sWheelSlotMask] != nullptr)
+                {
+                    nearTick = cascadeTick;
+                    break;
+                }
+            }
+        }
+
+        return mWheelBaseTime + nearTick * wheelTick();
+    }
+
+    void onTimerCancel(Timer* timer)
+    {
+        if (mWheelOwnerThread.load(std::memory_order_relaxed) == std::this_thread::get_id())
+        {
+            auto hold = wheelUnlink(timer);
+            (void) hold;
+            return;
+        }
+
+        if (mCancelPoster == nullptr)
+        {
+            // 只清除回调, 由时间轮在到期时移除
+            return;
+        }
+
+        // 投递期间由self保证定时器存活, 执行前可能已经到期移除
+        auto self = timer->shared_from_this();
+        mCancelPoster([this, self]() {
+            if (self->mOwner.load(std::memory_order_acquire) == this)
+            {
+                auto hold = wheelUnlink(self.get());
+                (void) hold;
+            }
+        });
     }
 
 private:
@@ -159,7 +451,30 @@ private:
         }
     };
 
+    const Mode mMode;
     std::priority_queue<Timer::Ptr, std::vector<Timer::Ptr>, CompareTimer> mTimers;
+
+    const std::chrono::steady_clock::time_point mWheelBaseTime;
+    uint64_t mCurrentTick = 0;
+    size_t mWheelTimerNum = 0;
+    std::array<std::array<Timer*, sWheelSlotNum>, sWheelLevelNum> mWheel{};
+    std::atomic<std::thread::id> mWheelOwnerThread{std::thread::id()};
+    Poster mCancelPoster;
+
+    friend class Timer;
 };
 
+void Timer::cancel()
+{
+    std::call_once(mExecuteOnceFlag, [this]() {
+        mCallback = nullptr;
+    });
+
+    auto owner = mOwner.load(std::memory_order_acquire);
+    if (owner != nullptr)
+    {
+        owner->onTimerCancel(this);
+    }
+}
+
 }}// namespace brynet::base
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <brynet/base/NonCopyable.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+namespace brynet { namespace base {
+
+// 令牌桶限速器(线程安全, 无锁): 每秒产生rate个令牌, 最多积累burst个.
+// 以GCRA(理论到达时间)实现, 只保存一个原子时间戳, 令牌按时间惰性补充, 不需要定时器逐次填充.
+// consume允许超出可用令牌数(例如多个线程同时消费同一个桶), 超出部分作为欠账, 推迟之后的可用时间
+class TokenBucket final : public NonCopyable
+{
+public:
+    using Ptr = std::shared_ptr<TokenBucket>;
+    using Clock = std::chrono::steady_clock;
+
+    static Ptr Create(uint64_t rate = 0, uint64_t burst = 0)
+    {
+        return std::make_shared<TokenBucket>(rate, burst);
+    }
+
+    explicit TokenBucket(uint64_t rate = 0, uint64_t burst = 0)
+        : mRate(0),
+          mBurst(0),
+          mTheoreticalArrival(0)
+    {
+        setRate(rate, burst);
+    }
+
+    // rate为0表示不限速, burst为0时取rate(最多突发1秒的流量)
+    void setRate(uint64_t rate, uint64_t burst = 0)
+    {
+        mBurst.store(burst == 0 ? rate : burst, std::memory_order_relaxed);
+        mRate.store(rate, std::memory_order_relaxed);
+    }
+
+    uint64_t rate() const
+    {
+        return mRate.load(std::memory_order_relaxed);
+    }
+
+    uint64_t burst() const
+    {
+        return mBurst.load(std::memory_order_relaxed);
+    }
+
+    bool unlimited() const
+    {
+        return rate() == 0;
+    }
+
+    // 当前可用令牌数, 不限速时返回size_t的最大值
+    size_t available(Clock::time_point now = Clock::now()) const
+    {
+        const auto r = rate();
+        if (r == 0)
+        {
+            return (std::numeric_limits<size_t>::max)();
+        }
+        const auto b = burst();
+        const auto credit = creditNanos(now, r, b);
+        if (credit <= 0)
+        {
+            return 0;
+        }
+        const auto tokens = static_cast<double>(credit) * static_cast<double>(r) / 1e9;
+        return static_cast<size_t>((std::min)(tokens, static_cast<double>(b)));
+    }
+
+    void consume(size_t n, Clock::time_point now = Clock::now())
+    {
+        const auto r = rate();
+        if (r == 0 || n == 0)
+        {
+            return;
+        }
+        const auto cost = costNanos(n, r);
+        const auto nowNanos = toNanos(now);
+        auto tat = mTheoreticalArrival.load(std::memory_order_relaxed);
+        while (!mTheoreticalArrival.compare_exchange_weak(tat,
+                                                          (std::max)(tat, nowNanos) + cost,
+                                                          std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // 距离可用令牌数达到n(超过burst时按burst计算)还需要等待的时间
+    std::chrono::nanoseconds waitTime(size_t n, Clock::time_point now = Clock::now()) const
+    {
+        const auto r = rate();
+        if (r == 0)
+        {
+            return std::chrono::nanoseconds::zero();
+        }
+        const auto b = burst();
+        const auto need = costNanos((std::min)(static_cast<uint64_t>(n), b), r) - creditNanos(now, r, b);
+        return std::chrono::nanoseconds((std::max)(need, static_cast<int64_t>(0)));
+    }
+
+private:
+    static int64_t toNanos(Clock::time_point t)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+
+    static int64_t costNanos(uint64_t n, uint64_t rate)
+    {
+        return static_cast<int64_t>(static_cast<double>(n) * 1e9 / static_cast<double>(rate) + 0.5);
+    }
+
+    // 已积累的令牌折算成的时间, 不超过burst对应的时间
+    int64_t creditNanos(Clock::time_point now, uint64_t rate, uint64_t burst) const
+    {
+        const auto burstNanos = costNanos(burst, rate);
+        const auto credit = toNanos(now) + burstNanos - mTheoreticalArrival.load(std::memory_order_relaxed);
+        return (std::min)(credit, burstNanos);
+    }
+
+private:
+    std::atomic<uint64_t> mRate;
+    std::atomic<uint64_t> mBurst;
+    std::atomic<int64_t> mTheoreticalArrival;
+};
+
+}}// namespace brynet::base
@@ -13,6 +13,10 @@ private:
     virtual void canSend() = 0;
     virtual void canRecv(bool willClose) = 0;
     virtual void onClose() = 0;
+    // (Linux)socket错误队列可读(EPOLLERR), 例如MSG_ZEROCOPY的完成通知
+    virtual void onErrorQueue()
+    {
+    }
 
     friend class EventLoop;
 };
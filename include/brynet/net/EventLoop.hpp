@@ -2,6 +2,8 @@
 
 #include <algorithm>
 #include <atomic>
+#include <brynet/base/MPSCRingQueue.hpp>
+#include <brynet/base/MoveOnlyFunction.hpp>
 #include <brynet/base/Noexcept.hpp>
 #include <brynet/base/NonCopyable.hpp>
 #include <brynet/base/Timer.hpp>
@@ -9,10 +11,18 @@
 #include <brynet/net/CurrentThread.hpp>
 #include <brynet/net/Exception.hpp>
 #include <brynet/net/Socket.hpp>
+#include <brynet/net/detail/EventLoopOption.hpp>
+#include <brynet/net/detail/EventLoopStats.hpp>
+#include <brynet/net/detail/TimerChannel.hpp>
 #include <brynet/net/detail/WakeupChannel.hpp>
+#include <brynet/net/port/IoUring.hpp>
+#ifndef BRYNET_PLATFORM_WINDOWS
+#include <brynet/net/detail/FdSlotTable.hpp>
+#endif
 #include <cassert>
 #include <cstdint>
 #include <functional>
+#include <iostream>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -22,16 +32,22 @@ namespace brynet { namespace net {
 
 class Channel;
 class TcpConnection;
+namespace detail {
+class AcceptChannel;
+class LoopListenerDetail;
+}
 using TcpConnectionPtr = std::shared_ptr<TcpConnection>;
+using EventLoopOption = detail::EventLoopOption;
+using EventLoopStats = detail::EventLoopStats;
 
 class EventLoop : public brynet::base::NonCopyable
 {
 public:
     using Ptr = std::shared_ptr<EventLoop>;
-    using UserFunctor = std::function<void(void)>;
+    using UserFunctor = brynet::base::MoveOnlyFunction<void(void)>;
 
 public:
-    EventLoop()
+    explicit EventLoop(EventLoopOption option = EventLoopOption())
             BRYNET_NOEXCEPT
         :
 #ifdef BRYNET_PLATFORM_WINDOWS
@@ -54,9 +70,24 @@ public:
             FreeLibrary(kernel32_module);
         }
 #elif defined BRYNET_PLATFORM_LINUX
+#ifdef BRYNET_USE_IO_URING
+        if (option.useIoUring)
+        {
+            mIoUring = port::IoUring::Create(1024);
+        }
+#endif
+        mBusyPollTime = option.busyPollTime;
+        mBusyPollBudget = option.busyPollTime;
         auto eventfd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
         mWakeupChannel.reset(new detail::WakeupChannel(eventfd));
         linkChannel(eventfd, mWakeupChannel.get());
+
+        auto timerfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (timerfd != -1)
+        {
+            mTimerChannel.reset(new detail::TimerChannel(timerfd));
+            linkChannel(timerfd, mTimerChannel.get());
+        }
 #elif defined BRYNET_PLATFORM_DARWIN
         const int NOTIFY_IDENT = 42;// Magic number we use for our filter ID.
         mWakeupChannel.reset(new detail::WakeupChannel(mKqueueFd, NOTIFY_IDENT));
@@ -73,7 +104,13 @@ public:
 
         reAllocEventSize(1024);
         mSelfThreadID = -1;
-        mTimer = std::make_shared<brynet::base::TimerMgr>();
+        mTimer = std::make_shared<brynet::base::TimerMgr>(option.useTimingWheel
+                                                                  ? brynet::base::TimerMgr::Mode::Wheel
+                                                                  : brynet::base::TimerMgr::Mode::Heap);
+        // 其他线程取消的定时器投递到loop线程从时间轮中移除
+        mTimer->setCancelPoster([this](brynet::base::Timer::Callback&& f) {
+            runAsyncFunctor(std::move(f));
+        });
     }
 
     virtual ~EventLoop() BRYNET_NOEXCEPT
@@ -107,6 +144,10 @@ public:
             milliseconds = 0;
         }
 
+        const auto loopStart = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point wakeupTime;
+        uint64_t eventCount = 0;
+
 #ifdef BRYNET_PLATFORM_WINDOWS
         ULONG numComplete = 0;
         if (mPGetQueuedCompletionStatusEx != nullptr)
@@ -141,6 +182,8 @@ public:
         }
 
         mIsInBlock = false;
+        wakeupTime = std::chrono::steady_clock::now();
+        eventCount = numComplete;
 
         for (ULONG i = 0; i < numComplete; ++i)
         {
@@ -161,30 +204,62 @@ public:
             }
         }
 #elif defined BRYNET_PLATFORM_LINUX
-        int numComplete = epoll_wait(mEpollFd, mEventEntries.data(), mEventEntries.size(), milliseconds);
+#ifdef BRYNET_USE_IO_URING
+        if (mIoUring != nullptr)
+        {
+            if (milliseconds != 0 &&
+                mBusyPollBudget > std::chrono::microseconds::zero() &&
+                busyPoll(milliseconds, [this]() {
+                    mIoUring->submitAndWait(0);
+                    return mIoUring->hasCompletions();
+                }))
+            {
+                milliseconds = 0;
+            }
+            mIoUring->submitAndWait(milliseconds);
 
-        mIsInBlock = false;
+            mIsInBlock = false;
+            wakeupTime = std::chrono::steady_clock::now();
 
-        for (int i = 0; i < numComplete; ++i)
+            eventCount = mIoUring->processCompletions([this](void* ptr, uint32_t events) {
+                processChannelEvents(static_cast<Channel*>(ptr), events);
+            });
+            if (mIoUring->armError() != 0)
+            {
+                fallbackToEpoll();
+            }
+        }
+        else
+#endif
         {
-            auto channel = (Channel*) (mEventEntries[i].data.ptr);
-            auto event_data = mEventEntries[i].events;
-
-            if (event_data & EPOLLRDHUP)
+            int numComplete = 0;
+            if (milliseconds != 0 &&
+                mBusyPollBudget > std::chrono::microseconds::zero() &&
+                busyPoll(milliseconds, [this, &numComplete]() {
+                    numComplete = epoll_wait(mEpollFd, mEventEntries.data(), mEventEntries.size(), 0);
+                    return numComplete > 0;
+                }))
             {
-                channel->canRecv(true);
-                channel->onClose();
-                continue;
+                milliseconds = 0;
+            }
+            if (numComplete <= 0)
+            {
+                numComplete = epoll_wait(mEpollFd, mEventEntries.data(), mEventEntries.size(), milliseconds);
             }
 
-            if (event_data & EPOLLIN)
+            mIsInBlock = false;
+            wakeupTime = std::chrono::steady_clock::now();
+            eventCount = numComplete > 0 ? numComplete : 0;
+
+            for (int i = 0; i < numComplete; ++i)
             {
-                channel->canRecv(false);
+                processChannelEvents(static_cast<Channel*>(mEventEntries[i].data.ptr),
+                                     mEventEntries[i].events);
             }
 
-            if (event_data & EPOLLOUT)
+            if (static_cast<size_t>(numComplete) == mEventEntries.size())
             {
-                channel->canSend();
+                reAllocEventSize(mEventEntries.size() + 128);
             }
         }
 #elif defined BRYNET_PLATFORM_DARWIN
@@ -192,6 +267,8 @@ public:
         int numComplete = kevent(mKqueueFd, NULL, 0, mEventEntries.data(), mEventEntries.size(), &timeout);
 
         mIsInBlock = false;
+        wakeupTime = std::chrono::steady_clock::now();
+        eventCount = numComplete > 0 ? numComplete : 0;
 
         for (int i = 0; i < numComplete; ++i)
         {
@@ -218,18 +295,55 @@ public:
         mIsAlreadyPostWakeup = false;
         mIsInBlock = true;
 
-        processAsyncFunctors();
+        const auto asyncFunctorCount = processAsyncFunctors();
+        const auto afterLoopStart = std::chrono::steady_clock::now();
         processAfterLoopFunctors();
 
+#ifndef BRYNET_PLATFORM_LINUX
         if (static_cast<size_t>(numComplete) == mEventEntries.size())
         {
             reAllocEventSize(mEventEntries.size() + 128);
         }
+#endif
 
+        const auto timerStart = std::chrono::steady_clock::now();
         mTimer->schedule();
+
+        mStats.recordIteration(loopStart,
+                               wakeupTime,
+                               afterLoopStart,
+                               timerStart,
+                               std::chrono::steady_clock::now(),
+                               eventCount,
+                               asyncFunctorCount);
+    }
+
+    // (线程安全)获取运行数据的快照
+    EventLoopStats getStats() const
+    {
+        return mStats.snapshot();
+    }
+
+    // (线程安全)绑定在此EventLoop上且尚未析构的TcpConnection数量
+    size_t getConnectionNum() const
+    {
+        return mConnectionNum.load(std::memory_order_relaxed);
+    }
+
+    // (线程安全)此EventLoop上所有连接尚未发送完成的字节数
+    size_t getPendingSendBytes() const
+    {
+        return mPendingSendBytes.load(std::memory_order_relaxed);
+    }
+
+    // (线程安全)最近一段时间内处理工作的时间占比
+    double getRecentUtilization() const
+    {
+        return mStats.recentUtilization();
     }
 
     // loop指定毫秒数,但如果定时器不为空,则loop时间为当前最近定时器的剩余时间和milliseconds的较小值
+    // Linux下由timerfd以纳秒精度唤醒, milliseconds为负数时表示没有事件时一直等待
     void loopCompareNearTimer(int64_t milliseconds)
     {
         tryInitThreadID();
@@ -244,8 +358,16 @@ public:
 
         if (!mTimer->isEmpty())
         {
+#ifdef BRYNET_PLATFORM_LINUX
+            // 由timerfd在到期时唤醒, 不需要把等待时间截断为毫秒
+            if (mTimerChannel != nullptr && mTimerChannel->arm(mTimer->nearExpireTime()))
+            {
+                loop(milliseconds);
+                return;
+            }
+#endif
             auto nearTimeout = std::chrono::duration_cast<std::chrono::milliseconds>(mTimer->nearLeftTime());
-            milliseconds = std::min<int64_t>(milliseconds, nearTimeout.count());
+            milliseconds = milliseconds < 0 ? nearTimeout.count() : std::min<int64_t>(milliseconds, nearTimeout.count());
         }
 
         loop(milliseconds);
@@ -254,7 +376,14 @@ public:
     // 返回true表示实际发生了wakeup所需的操作(此返回值不代表接口本身操作成功与否,因为此函数永远成功)
     bool wakeup()
     {
-        if (!isInLoopThread() && mIsInBlock && !mIsAlreadyPostWakeup.exchange(true))
+        if (isInLoopThread())
+        {
+            return false;
+        }
+
+        // 忙轮询期间mIsInBlock为false而不写eventfd, 由busyPoll检查此标记(与mIsInBlock配合, 需要顺序一致)
+        mWakeupPending.store(true);
+        if (mIsInBlock && !mIsAlreadyPostWakeup.exchange(true))
         {
             return mWakeupChannel->wakeup();
         }
@@ -311,64 +440,106 @@ public:
         return mSelfThreadID == current_thread::tid();
     }
 
+    // 当前是否以io_uring作为事件引擎(未开启、内核不支持或运行中回退到epoll时返回false)
+    bool isIoUringEnabled() const
+    {
+#if defined BRYNET_PLATFORM_LINUX && defined BRYNET_USE_IO_URING
+        return mIoUring != nullptr;
+#else
+        return false;
+#endif
+    }
+
 private:
     void reAllocEventSize(size_t size)
     {
         mEventEntries.resize(size);
     }
 
-    void processAfterLoopFunctors()
+#ifdef BRYNET_PLATFORM_LINUX
+    void processChannelEvents(Channel* channel, uint32_t events)
     {
-        mCopyAfterLoopFunctors.swap(mAfterLoopFunctors);
-        for (const auto& x : mCopyAfterLoopFunctors)
+        if (events & EPOLLERR)
         {
-            x();
+            channel->onErrorQueue();
+        }
+
+        if (events & EPOLLRDHUP)
+        {
+            channel->canRecv(true);
+            channel->onClose();
+            return;
+        }
+
+        if (events & EPOLLIN)
+        {
+            channel->canRecv(false);
+        }
+
+        if (events & EPOLLOUT)
+        {
+            channel->canSend();
         }
-        mCopyAfterLoopFunctors.clear();
     }
-    void processAsyncFunctors()
+
+#ifdef BRYNET_USE_IO_URING
+    // 内核不支持multishot poll时整个loop回退到epoll: 把所有fd以原来的事件注册到epoll,
+    // EPOLL_CTL_ADD会立即检测一次就绪状态, 不会丢失迁移期间的事件
+    void fallbackToEpoll()
     {
-        swapAsyncFunctors();
+        std::cerr << "io_uring poll error:" << mIoUring->armError() << ", fallback to epoll" << std::endl;
+        mIoUring->foreachChannel([this](BrynetSocketFD fd, void* ptr, uint32_t events) {
+            struct epoll_event ev = {0,
+                                     {
+                                         nullptr
+                                     }};
+            ev.events = events;
+            ev.data.ptr = ptr;
+            epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &ev);
+        });
+        mIoUring.reset();
+    }
+#endif
+#endif
 
-        for (const auto& x : mCopyAsyncFunctors)
+    void processAfterLoopFunctors()
+    {
+        mCopyAfterLoopFunctors.swap(mAfterLoopFunctors);
+        for (const auto& x : mCopyAfterLoopFunctors)
         {
             x();
         }
-        mCopyAsyncFunctors.clear();
+        mCopyAfterLoopFunctors.clear();
     }
-    void swapAsyncFunctors()
+    size_t processAsyncFunctors()
     {
-        std::lock_guard<std::mutex> lck(mAsyncFunctorsMutex);
-        assert(mCopyAsyncFunctors.empty());
-        mCopyAsyncFunctors.swap(mAsyncFunctors);
+        return mAsyncFunctors.popAll([](const UserFunctor& x) {
+            x();
+        });
     }
     void pushAsyncFunctor(UserFunctor&& f)
     {
-        std::lock_guard<std::mutex> lck(mAsyncFunctorsMutex);
-        mAsyncFunctors.emplace_back(std::move(f));
+        mAsyncFunctors.push(std::move(f));
     }
 
-#ifdef BRYNET_PLATFORM_LINUX
-    int getEpollHandle() const
-    {
-        return mEpollFd;
-    }
-#elif defined BRYNET_PLATFORM_DARWIN
-    int getKqueueHandle() const
-    {
-        return mKqueueFd;
-    }
-#endif
-    bool linkChannel(BrynetSocketFD fd, const Channel* ptr) BRYNET_NOEXCEPT
+    // enableWrite为false时只关注可读事件, 之后可通过recheckChannel开启可写事件
+    bool linkChannel(BrynetSocketFD fd, const Channel* ptr, bool enableWrite = true) BRYNET_NOEXCEPT
     {
 #ifdef BRYNET_PLATFORM_WINDOWS
+        (void) enableWrite;
         return CreateIoCompletionPort((HANDLE) fd, mIOCP, (ULONG_PTR) ptr, 0) != nullptr;
 #elif defined BRYNET_PLATFORM_LINUX
+#ifdef BRYNET_USE_IO_URING
+        if (mIoUring != nullptr)
+        {
+            return mIoUring->addChannel(fd, (void*) ptr, EpollEvents(enableWrite));
+        }
+#endif
         struct epoll_event ev = {0,
                                  {
                                      nullptr
                                  }};
-        ev.events = EPOLLET | EPOLLIN | EPOLLOUT | EPOLLRDHUP;
+        ev.events = EpollEvents(enableWrite);
         ev.data.ptr = (void*) ptr;
         return epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &ev) == 0;
 #elif defined BRYNET_PLATFORM_DARWIN
@@ -376,29 +547,158 @@ private:
         memset(&ev, 0, sizeof(ev));
         int n = 0;
         EV_SET(&ev[n++], fd, EVFILT_READ, EV_ADD | EV_CLEAR, NOTE_TRIGGER, 0, (void*) ptr);
-        EV_SET(&ev[n++], fd, EVFILT_WRITE, EV_ADD | EV_CLEAR, NOTE_TRIGGER, 0, (void*) ptr);
+        EV_SET(&ev[n++], fd, EVFILT_WRITE, EV_ADD | EV_CLEAR | (enableWrite ? 0 : EV_DISABLE), NOTE_TRIGGER, 0, (void*) ptr);
 
         struct timespec now = {0, 0};
         return kevent(mKqueueFd, ev, n, NULL, 0, &now) == 0;
 #endif
     }
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+    // 强制重新检测fd的读写事件, 同时设置是否关注可写/可读事件
+    void recheckChannel(BrynetSocketFD fd, const Channel* ptr, bool enableWrite = true, bool enableRead = true)
+    {
+        mStats.recordChannelUpdate();
+#ifdef BRYNET_PLATFORM_LINUX
+#ifdef BRYNET_USE_IO_URING
+        if (mIoUring != nullptr)
+        {
+            mIoUring->rearmChannel(fd, EpollEvents(enableWrite, enableRead));
+            return;
+        }
+#endif
+        struct epoll_event ev = {0,
+                                 {
+                                     nullptr
+                                 }};
+        ev.events = EpollEvents(enableWrite, enableRead);
+        ev.data.ptr = (void*) ptr;
+        epoll_ctl(mEpollFd, EPOLL_CTL_MOD, fd, &ev);
+#elif defined BRYNET_PLATFORM_DARWIN
+        struct kevent ev[2];
+        memset(&ev, 0, sizeof(ev));
+        int n = 0;
+        EV_SET(&ev[n++], fd, EVFILT_READ, enableRead ? EV_ENABLE : EV_DISABLE, 0, 0, (void*) ptr);
+        EV_SET(&ev[n++], fd, EVFILT_WRITE, enableWrite ? EV_ENABLE : EV_DISABLE, 0, 0, (void*) ptr);
+
+        struct timespec now = {0, 0};
+        kevent(mKqueueFd, ev, n, NULL, 0, &now);
+#endif
+    }
+#ifdef BRYNET_PLATFORM_LINUX
+    // 不关注可读事件时同时去掉EPOLLRDHUP, 对端关闭要等到重新关注可读时才处理
+    static uint32_t EpollEvents(bool enableWrite, bool enableRead = true)
+    {
+        return static_cast<uint32_t>(EPOLLET) |
+               (enableRead ? static_cast<uint32_t>(EPOLLIN | EPOLLRDHUP) : 0u) |
+               (enableWrite ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    }
+
+    // 在忙轮询预算内以零超时调用poll, poll返回true或其他线程调用过wakeup(包括投递异步函数)时返回true.
+    // 轮询期间mIsInBlock为false, 其他线程wakeup时不会写eventfd
+    template<typename Poll>
+    bool busyPoll(int64_t milliseconds, Poll&& poll)
+    {
+        auto budget = mBusyPollBudget;
+        if (milliseconds > 0)
+        {
+            budget = std::min<std::chrono::microseconds>(budget, std::chrono::milliseconds(milliseconds));
+        }
+        const auto deadline = std::chrono::steady_clock::now() + budget;
+
+        // 之前的wakeup要么已写eventfd, 要么发生在处理事件期间(之后会检查异步函数与退出标记)
+        mWakeupPending.store(false);
+        mIsInBlock = false;
+        bool ready = false;
+        do
+        {
+            if (poll() || mWakeupPending.load())
+            {
+                ready = true;
+                break;
+            }
+        } while (std::chrono::steady_clock::now() < deadline);
+        mIsInBlock = true;
+
+        // 命中时恢复完整预算, 落空时减半(不低于1/16), 避免空闲时持续占用CPU
+        if (ready)
+        {
+            mBusyPollBudget = mBusyPollTime;
+        }
+        else
+        {
+            const auto minBudget = std::max(mBusyPollTime / 16, std::chrono::microseconds(1));
+            mBusyPollBudget = std::max(mBusyPollBudget / 2, minBudget);
+        }
+
+        // 设置mIsInBlock之后再次检查, 避免wakeup看到mIsInBlock为false而未写eventfd
+        return ready || mWakeupPending.load();
+    }
+#endif
+
+    void unlinkChannel(BrynetSocketFD fd)
+    {
+#ifdef BRYNET_PLATFORM_LINUX
+#ifdef BRYNET_USE_IO_URING
+        if (mIoUring != nullptr)
+        {
+            mIoUring->removeChannel(fd);
+            return;
+        }
+#endif
+        struct epoll_event ev = {0,
+                                 {
+                                     nullptr
+                                 }};
+        epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, &ev);
+#elif defined BRYNET_PLATFORM_DARWIN
+        struct kevent ev[2];
+        memset(&ev, 0, sizeof(ev));
+        int n = 0;
+        EV_SET(&ev[n++], fd, EVFILT_READ, EV_DELETE, 0, 0, NULL);
+        EV_SET(&ev[n++], fd, EVFILT_WRITE, EV_DELETE, 0, 0, NULL);
+
+        struct timespec now = {0, 0};
+        kevent(mKqueueFd, ev, n, NULL, 0, &now);
+#endif
+    }
+#endif
     TcpConnectionPtr getTcpConnection(BrynetSocketFD fd)
     {
+#ifdef BRYNET_PLATFORM_WINDOWS
         auto it = mTcpConnections.find(fd);
         if (it != mTcpConnections.end())
         {
             return (*it).second;
         }
         return nullptr;
+#else
+        auto tcpConnection = mTcpConnections.findByFd(fd);
+        return tcpConnection != nullptr ? *tcpConnection : nullptr;
+#endif
     }
     void addTcpConnection(BrynetSocketFD fd, TcpConnectionPtr tcpConnection)
     {
+#ifdef BRYNET_PLATFORM_WINDOWS
         mTcpConnections[fd] = std::move(tcpConnection);
+#else
+        mTcpConnections.insert(fd, std::move(tcpConnection));
+#endif
     }
     void removeTcpConnection(BrynetSocketFD fd)
     {
         mTcpConnections.erase(fd);
     }
+    // 以下两个函数只在loop线程调用, 单一写者无需原子的读改写
+    void increasePendingSendBytes(size_t len)
+    {
+        mPendingSendBytes.store(mPendingSendBytes.load(std::memory_order_relaxed) + len,
+                                std::memory_order_relaxed);
+    }
+    void decreasePendingSendBytes(size_t len)
+    {
+        mPendingSendBytes.store(mPendingSendBytes.load(std::memory_order_relaxed) - len,
+                                std::memory_order_relaxed);
+    }
     void tryInitThreadID()
     {
         std::call_once(mOnceInitThreadID, [this]() {
@@ -416,18 +716,27 @@ private:
 #elif defined BRYNET_PLATFORM_LINUX
     std::vector<epoll_event> mEventEntries;
     int mEpollFd;
+#ifdef BRYNET_USE_IO_URING
+    std::unique_ptr<port::IoUring> mIoUring;
+#endif
 #elif defined BRYNET_PLATFORM_DARWIN
     std::vector<struct kevent> mEventEntries;
     int mKqueueFd;
 #endif
     std::unique_ptr<detail::WakeupChannel> mWakeupChannel;
+#ifdef BRYNET_PLATFORM_LINUX
+    std::unique_ptr<detail::TimerChannel> mTimerChannel;
+    std::chrono::microseconds mBusyPollTime;
+    std::chrono::microseconds mBusyPollBudget;
+#endif
 
     std::atomic_bool mIsInBlock;
     std::atomic_bool mIsAlreadyPostWakeup;
 
-    std::mutex mAsyncFunctorsMutex;
-    std::vector<UserFunctor> mAsyncFunctors;
-    std::vector<UserFunctor> mCopyAsyncFunctors;
+    // 其他线程投递的异步函数, 环满时才加锁
+    static const size_t sAsyncFunctorCapacity = 1024;
+    brynet::base::MPSCRingQueue<UserFunctor> mAsyncFunctors{sAsyncFunctorCapacity};
+    std::atomic_bool mWakeupPending{false};
 
     std::vector<UserFunctor> mAfterLoopFunctors;
     std::vector<UserFunctor> mCopyAfterLoopFunctors;
@@ -436,9 +745,20 @@ private:
     current_thread::THREAD_ID_TYPE mSelfThreadID;
 
     brynet::base::TimerMgr::Ptr mTimer;
+    detail::EventLoopStatsRecorder mStats;
+    // TcpConnection可能在任意线程构造或析构
+    std::atomic<size_t> mConnectionNum{0};
+    std::atomic<size_t> mPendingSendBytes{0};
+#ifdef BRYNET_PLATFORM_WINDOWS
+    // SOCKET是内核句柄, 数值不保证稠密
     std::unordered_map<BrynetSocketFD, TcpConnectionPtr> mTcpConnections;
+#else
+    detail::FdSlotTable<TcpConnectionPtr> mTcpConnections;
+#endif
 
     friend class TcpConnection;
+    friend class detail::AcceptChannel;
+    friend class detail::LoopListenerDetail;
 };
 
 }}// namespace brynet::net
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <brynet/net/detail/LoopListenerDetail.hpp>
+
+namespace brynet { namespace net {
+
+class LoopListener : public detail::LoopListenerDetail,
+                     public std::enable_shared_from_this<LoopListener>
+{
+public:
+    using Ptr = std::shared_ptr<LoopListener>;
+    using AccepCallback = std::function<void(TcpSocket::Ptr)>;
+    using TcpSocketProcessCallback = std::function<void(TcpSocket&)>;
+
+    void startListen()
+    {
+        detail::LoopListenerDetail::startListen();
+    }
+
+    void stopListen()
+    {
+        detail::LoopListenerDetail::stopListen();
+    }
+
+public:
+    static Ptr Create(TcpService::Ptr service,
+                      bool isIPV6,
+                      const std::string& ip,
+                      int port,
+                      const AccepCallback& callback,
+                      const std::vector<TcpSocketProcessCallback>& processCallbacks = {})
+    {
+        class make_shared_enabler : public LoopListener
+        {
+        public:
+            make_shared_enabler(TcpService::Ptr service,
+                                bool isIPV6,
+                                const std::string& ip,
+                                int port,
+                                const AccepCallback& callback,
+                                const std::vector<TcpSocketProcessCallback>& processCallbacks)
+                : LoopListener(std::move(service), isIPV6, ip, port, callback, processCallbacks)
+            {}
+        };
+        return std::make_shared<make_shared_enabler>(std::move(service), isIPV6, ip, port, callback, processCallbacks);
+    }
+
+protected:
+    LoopListener(TcpService::Ptr service,
+                 bool isIPV6,
+                 const std::string& ip,
+                 int port,
+                 const AccepCallback& callback,
+                 const std::vector<TcpSocketProcessCallback>& processCallbacks)
+        : detail::LoopListenerDetail(std::move(service), isIPV6, ip, port, callback, processCallbacks)
+    {}
+};
+
+}}// namespace brynet::net
@@ -3,6 +3,12 @@
 #include <brynet/base/Noexcept.hpp>
 #include <brynet/base/NonCopyable.hpp>
 #include <brynet/base/Platform.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -15,7 +21,14 @@
 extern "C" {
 #endif
 #include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
 #include <openssl/ssl.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#else
+#include <openssl/hmac.h>
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -24,6 +37,8 @@ extern "C" {
 
 namespace brynet { namespace net {
 
+class TcpConnection;
+
 #ifdef BRYNET_USE_OPENSSL
 
 #ifndef CRYPTO_THREADID_set_callback
@@ -126,9 +141,122 @@ public:
             return false;
         }
 
+        SSL_CTX_set_app_data(mOpenSSLCTX, this);
+        static const unsigned char sessionIDContext[] = "brynet";
+        SSL_CTX_set_session_id_context(mOpenSSLCTX, sessionIDContext, sizeof(sessionIDContext) - 1);
+        applySessionCache();
+        applySessionTicket();
+
+        return true;
+    }
+
+    // (客户端)创建供多个出站连接共用的SSL_CTX(见ConnectionBuilder::WithSSL), 并按(主机, 端口)缓存会话,
+    // 重复连接同一上游时恢复会话. verifyPeer为true时校验服务端证书(caFile为空时使用系统默认CA),
+    // 连接指定了serverName时还会校验证书中的主机名
+    bool initClientSSL(bool verifyPeer = false, const std::string& caFile = "")
+    {
+        std::call_once(initCryptoThreadSafeSupportOnceFlag,
+                       InitCryptoThreadSafeSupport);
+
+        if (mOpenSSLCTX != nullptr)
+        {
+            return false;
+        }
+
+        mOpenSSLCTX = SSL_CTX_new(SSLv23_client_method());
+        if (mOpenSSLCTX == nullptr)
+        {
+            return false;
+        }
+        if (verifyPeer)
+        {
+            const auto loaded = caFile.empty()
+                                        ? SSL_CTX_set_default_verify_paths(mOpenSSLCTX)
+                                        : SSL_CTX_load_verify_locations(mOpenSSLCTX, caFile.c_str(), nullptr);
+            if (loaded != 1)
+            {
+                SSL_CTX_free(mOpenSSLCTX);
+                mOpenSSLCTX = nullptr;
+                return false;
+            }
+            SSL_CTX_set_verify(mOpenSSLCTX, SSL_VERIFY_PEER, nullptr);
+        }
+
+        SSL_CTX_set_app_data(mOpenSSLCTX, this);
+        // 会话由SSLHelper按(主机, 端口)保存, 不使用OpenSSL内部的缓存
+        SSL_CTX_set_session_cache_mode(mOpenSSLCTX, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(mOpenSSLCTX, NewClientSessionCallback);
+
         return true;
     }
 
+    // (服务端)会话缓存: 由所有工作线程共用, 保存最近cacheSize个会话供客户端以session id恢复(TLS 1.2),
+    // 会话及票据的有效期为timeout. cacheSize为0表示关闭会话缓存. 可以在initSSL之前或之后调用
+    void setSessionCache(size_t cacheSize, std::chrono::seconds timeout)
+    {
+        mSessionCacheSize = cacheSize;
+        mSessionTimeout = timeout;
+        applySessionCache();
+    }
+
+    // (服务端)会话票据(TLS 1.2票据以及TLS 1.3的无状态恢复): 票据密钥由SSLHelper保存, 每隔rotateInterval更换一次,
+    // 旧密钥在下一个周期内仍可解密(并为客户端换发新票据), 所以票据最长有效2个周期(同时不超过会话有效期).
+    // rotateInterval为0表示不主动更换(只能调用rotateSessionTicketKey更换). 不调用时使用OpenSSL进程内的固定随机密钥
+    void enableSessionTicket(std::chrono::seconds rotateInterval)
+    {
+        {
+            std::lock_guard<std::mutex> lck(mTicketKeyGuard);
+            mTicketKeyRotateInterval = rotateInterval;
+            mUseTicketKeyCallback = true;
+            mDisableTicket = false;
+        }
+        applySessionTicket();
+    }
+
+    // (服务端)关闭会话票据, TLS 1.3改为使用会话缓存恢复
+    void disableSessionTicket()
+    {
+        {
+            std::lock_guard<std::mutex> lck(mTicketKeyGuard);
+            mUseTicketKeyCallback = false;
+            mDisableTicket = true;
+        }
+        applySessionTicket();
+    }
+
+    // 立即更换票据密钥, 上一个密钥仍可解密
+    void rotateSessionTicketKey()
+    {
+        std::lock_guard<std::mutex> lck(mTicketKeyGuard);
+        rotateTicketKeyLocked(std::chrono::steady_clock::now());
+    }
+
+    // (客户端, 线程安全)最多保存cacheSize个上游(主机, 端口)的会话, 超出时先移除不可恢复或已过期的会话,
+    // 仍然超出时移除最早建立的会话. cacheSize为0表示不保存会话. 默认1024
+    void setClientSessionCacheSize(size_t cacheSize)
+    {
+        std::lock_guard<std::mutex> lck(mClientSessionGuard);
+        mClientSessionCacheSize = cacheSize;
+        shrinkClientSessionsLocked(cacheSize);
+    }
+
+    size_t getClientSessionNum()
+    {
+        std::lock_guard<std::mutex> lck(mClientSessionGuard);
+        return mClientSessions.size();
+    }
+
+    // (线程安全)完整握手与会话恢复握手的次数
+    uint64_t getFullHandshakeCount() const
+    {
+        return mFullHandshakeCount.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getResumedHandshakeCount() const
+    {
+        return mResumedHandshakeCount.load(std::memory_order_relaxed);
+    }
+
     void destroySSL()
     {
         if (mOpenSSLCTX != nullptr)
@@ -136,6 +264,13 @@ public:
             SSL_CTX_free(mOpenSSLCTX);
             mOpenSSLCTX = nullptr;
         }
+
+        std::lock_guard<std::mutex> lck(mClientSessionGuard);
+        for (const auto& v : mClientSessions)
+        {
+            SSL_SESSION_free(v.second);
+        }
+        mClientSessions.clear();
     }
 
     SSL_CTX* getOpenSSLCTX()
@@ -156,6 +291,12 @@ protected:
     {
 #ifdef BRYNET_USE_OPENSSL
         mOpenSSLCTX = nullptr;
+        mSessionCacheSize = SSL_SESSION_CACHE_MAX_SIZE_DEFAULT;
+        mSessionTimeout = std::chrono::seconds(300);
+        mClientSessionCacheSize = 1024;
+        mUseTicketKeyCallback = false;
+        mDisableTicket = false;
+        mTicketKeyRotateInterval = std::chrono::seconds::zero();
 #endif
     }
 
@@ -168,7 +309,299 @@ protected:
 
 private:
 #ifdef BRYNET_USE_OPENSSL
+    friend class TcpConnection;
+
+    struct TicketKey
+    {
+        std::array<unsigned char, 16> name;
+        std::array<unsigned char, 32> aesKey;
+        std::array<unsigned char, 32> hmacKey;
+    };
+
+    void onHandshakeCompleted(SSL* ssl)
+    {
+        if (SSL_session_reused(ssl))
+        {
+            mResumedHandshakeCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            mFullHandshakeCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // 返回key对应的可恢复会话(调用者负责SSL_SESSION_free), 没有时返回nullptr
+    SSL_SESSION* getClientSession(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lck(mClientSessionGuard);
+        const auto it = mClientSessions.find(key);
+        if (it == mClientSessions.end())
+        {
+            return nullptr;
+        }
+        if (!IsClientSessionUsable(it->second, time(nullptr)))
+        {
+            SSL_SESSION_free(it->second);
+            mClientSessions.erase(it);
+            return nullptr;
+        }
+        SSL_SESSION_up_ref(it->second);
+        return it->second;
+    }
+
+    // 握手完成(以及TLS 1.3收到新票据)时调用, 返回1表示接管session的引用.
+    // SSL的app data为TcpConnection设置的会话键(主机:端口)
+    static int NewClientSessionCallback(SSL* ssl, SSL_SESSION* session)
+    {
+        auto helper = static_cast<SSLHelper*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+        const auto key = static_cast<const std::string*>(SSL_get_app_data(ssl));
+        if (helper == nullptr || key == nullptr || !SSL_SESSION_is_resumable(session))
+        {
+            return 0;
+        }
+
+        std::lock_guard<std::mutex> lck(helper->mClientSessionGuard);
+        const auto it = helper->mClientSessions.find(*key);
+        if (it != helper->mClientSessions.end())
+        {
+            SSL_SESSION_free(it->second);
+            it->second = session;
+            return 1;
+        }
+        if (helper->mClientSessionCacheSize == 0)
+        {
+            return 0;
+        }
+
+        helper->shrinkClientSessionsLocked(helper->mClientSessionCacheSize - 1);
+        helper->mClientSessions.emplace(*key, session);
+        return 1;
+    }
+
+    static bool IsClientSessionUsable(const SSL_SESSION* session, time_t now)
+    {
+        return SSL_SESSION_is_resumable(session) &&
+               SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session) > now;
+    }
+
+    // 把会话数减少到不超过maxNum: 先移除不可恢复或已过期的会话, 再按建立时间从早到晚移除
+    void shrinkClientSessionsLocked(size_t maxNum)
+    {
+        if (mClientSessions.size() <= maxNum)
+        {
+            return;
+        }
+
+        const auto now = time(nullptr);
+        for (auto it = mClientSessions.begin(); it != mClientSessions.end();)
+        {
+            if (IsClientSessionUsable(it->second, now))
+            {
+                ++it;
+                continue;
+            }
+            SSL_SESSION_free(it->second);
+            it = mClientSessions.erase(it);
+        }
+
+        while (mClientSessions.size() > maxNum)
+        {
+            auto oldest = mClientSessions.begin();
+            for (auto it = oldest; it != mClientSessions.end(); ++it)
+            {
+                if (SSL_SESSION_get_time(it->second) < SSL_SESSION_get_time(oldest->second))
+                {
+                    oldest = it;
+                }
+            }
+            SSL_SESSION_free(oldest->second);
+            mClientSessions.erase(oldest);
+        }
+    }
+
+    void applySessionCache()
+    {
+        if (mOpenSSLCTX == nullptr)
+        {
+            return;
+        }
+        if (mSessionCacheSize == 0)
+        {
+            SSL_CTX_set_session_cache_mode(mOpenSSLCTX, SSL_SESS_CACHE_OFF);
+            // 关闭缓存不会阻止查找已缓存的会话, 需要清空(时间为0表示移除全部)
+            SSL_CTX_flush_sessions(mOpenSSLCTX, 0);
+            return;
+        }
+        SSL_CTX_set_session_cache_mode(mOpenSSLCTX, SSL_SESS_CACHE_SERVER);
+        SSL_CTX_sess_set_cache_size(mOpenSSLCTX, static_cast<long>(mSessionCacheSize));
+        SSL_CTX_set_timeout(mOpenSSLCTX, static_cast<long>(mSessionTimeout.count()));
+    }
+
+    void applySessionTicket()
+    {
+        if (mOpenSSLCTX == nullptr)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lck(mTicketKeyGuard);
+        if (mDisableTicket)
+        {
+            SSL_CTX_set_options(mOpenSSLCTX, SSL_OP_NO_TICKET);
+            return;
+        }
+        SSL_CTX_clear_options(mOpenSSLCTX, SSL_OP_NO_TICKET);
+        if (!mUseTicketKeyCallback)
+        {
+            return;
+        }
+        if (mTicketKeys.empty())
+        {
+            rotateTicketKeyLocked(std::chrono::steady_clock::now());
+        }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        SSL_CTX_set_tlsext_ticket_key_evp_cb(mOpenSSLCTX, TicketKeyCallback);
+#else
+        SSL_CTX_set_tlsext_ticket_key_cb(mOpenSSLCTX, TicketKeyCallback);
+#endif
+    }
+
+    // 新密钥放在队首, 只保留当前和上一个密钥
+    void rotateTicketKeyLocked(std::chrono::steady_clock::time_point now)
+    {
+        TicketKey key;
+        if (RAND_bytes(key.name.data(), static_cast<int>(key.name.size())) != 1 ||
+            RAND_bytes(key.aesKey.data(), static_cast<int>(key.aesKey.size())) != 1 ||
+            RAND_bytes(key.hmacKey.data(), static_cast<int>(key.hmacKey.size())) != 1)
+        {
+            return;
+        }
+        mTicketKeys.push_front(key);
+        while (mTicketKeys.size() > 2)
+        {
+            mTicketKeys.pop_back();
+        }
+        mTicketKeyRotateTime = now;
+    }
+
+    // 返回用于加密的当前密钥, 或按名称查找用于解密的密钥(isCurrent表示是否为当前密钥)
+    bool findTicketKey(const unsigned char* name, bool encrypt, TicketKey& key, bool& isCurrent)
+    {
+        std::lock_guard<std::mutex> lck(mTicketKeyGuard);
+        const auto now = std::chrono::steady_clock::now();
+        if (mTicketKeyRotateInterval.count() > 0 && now - mTicketKeyRotateTime >= mTicketKeyRotateInterval)
+        {
+            rotateTicketKeyLocked(now);
+        }
+        if (mTicketKeys.empty())
+        {
+            return false;
+        }
+        if (encrypt)
+        {
+            key = mTicketKeys.front();
+            isCurrent = true;
+            return true;
+        }
+        for (size_t i = 0; i < mTicketKeys.size(); i++)
+        {
+            if (memcmp(mTicketKeys[i].name.data(), name, mTicketKeys[i].name.size()) == 0)
+            {
+                key = mTicketKeys[i];
+                isCurrent = (i == 0);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 返回值: 加密时1为成功; 解密时0为找不到密钥(进行完整握手), 1为成功, 2为成功且需要换发新票据, 负数为出错
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    static int TicketKeyCallback(SSL* ssl,
+                                 unsigned char* keyName,
+                                 unsigned char* iv,
+                                 EVP_CIPHER_CTX* cipherCtx,
+                                 EVP_MAC_CTX* hmacCtx,
+                                 int encrypt)
+#else
+    static int TicketKeyCallback(SSL* ssl,
+                                 unsigned char* keyName,
+                                 unsigned char* iv,
+                                 EVP_CIPHER_CTX* cipherCtx,
+                                 HMAC_CTX* hmacCtx,
+                                 int encrypt)
+#endif
+    {
+        auto helper = static_cast<SSLHelper*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+        TicketKey key;
+        bool isCurrent = false;
+        if (helper == nullptr || !helper->findTicketKey(keyName, encrypt == 1, key, isCurrent))
+        {
+            return encrypt == 1 ? -1 : 0;
+        }
+
+        const auto cipher = EVP_aes_256_cbc();
+        if (encrypt == 1)
+        {
+            memcpy(keyName, key.name.data(), key.name.size());
+            if (RAND_bytes(iv, EVP_CIPHER_iv_length(cipher)) != 1 ||
+                EVP_EncryptInit_ex(cipherCtx, cipher, nullptr, key.aesKey.data(), iv) != 1)
+            {
+                return -1;
+            }
+        }
+        else if (EVP_DecryptInit_ex(cipherCtx, cipher, nullptr, key.aesKey.data(), iv) != 1)
+        {
+            return -1;
+        }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        char digest[] = "SHA256";
+        OSSL_PARAM params[] = {
+                OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.hmacKey.data(), key.hmacKey.size()),
+                OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+                OSSL_PARAM_construct_end(),
+        };
+        if (EVP_MAC_CTX_set_params(hmacCtx, params) != 1)
+        {
+            return -1;
+        }
+#else
+        if (HMAC_Init_ex(hmacCtx, key.hmacKey.data(), static_cast<int>(key.hmacKey.size()), EVP_sha256(), nullptr) != 1)
+        {
+            return -1;
+        }
+#endif
+        if (encrypt == 1)
+        {
+            return 1;
+        }
+#ifdef TLS1_3_VERSION
+        // TLS 1.3客户端只使用一次票据, 每次恢复都需要换发新票据, 否则下一次连接只能完整握手
+        if (SSL_version(ssl) == TLS1_3_VERSION)
+        {
+            return 2;
+        }
+#endif
+        return isCurrent ? 1 : 2;
+    }
+
     SSL_CTX* mOpenSSLCTX;
+    size_t mSessionCacheSize;
+    std::chrono::seconds mSessionTimeout;
+
+    std::mutex mTicketKeyGuard;
+    bool mUseTicketKeyCallback;
+    bool mDisableTicket;
+    std::chrono::seconds mTicketKeyRotateInterval;
+    std::chrono::steady_clock::time_point mTicketKeyRotateTime;
+    std::deque<TicketKey> mTicketKeys;
+
+    std::mutex mClientSessionGuard;
+    size_t mClientSessionCacheSize;
+    std::unordered_map<std::string, SSL_SESSION*> mClientSessions;
+
+    std::atomic<uint64_t> mFullHandshakeCount{0};
+    std::atomic<uint64_t> mResumedHandshakeCount{0};
 #endif
 };
 
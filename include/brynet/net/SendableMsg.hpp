@@ -1,8 +1,18 @@
+#include <brynet/base/Platform.hpp>
 #include <memory>
 #include <string>
+#include <vector>
+
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+#include <sys/types.h>
+#include <unistd.h>
+#endif
 
 namespace brynet { namespace net {
 
+class FileSendMsg;
+class SlicesSendMsg;
+
 class SendableMsg
 {
 public:
@@ -12,6 +22,18 @@ public:
 
     virtual const void* data() = 0;
     virtual size_t size() = 0;
+
+    // 文件区间消息返回自身, 内存消息返回nullptr
+    virtual FileSendMsg* asFileMsg()
+    {
+        return nullptr;
+    }
+
+    // 多片段消息返回自身, 其他消息返回nullptr
+    virtual SlicesSendMsg* asSlicesMsg()
+    {
+        return nullptr;
+    }
 };
 
 class StringSendMsg : public SendableMsg
@@ -57,4 +79,128 @@ static SendableMsg::Ptr MakeStringMsg(std::string&& buffer)
     return std::make_shared<StringSendMsg>(std::move(buffer));
 }
 
+// 多片段消息: 由多个内存消息按顺序组成, 发送时每个片段对应一个iovec, 不需要先拼接到一块连续内存.
+// 片段可以是独享的(例如每个连接不同的协议头), 也可以是多个连接共享的同一个消息(例如广播的消息体).
+// data()返回nullptr, 片段必须是普通的内存消息(不能是文件区间消息或多片段消息)
+class SlicesSendMsg : public SendableMsg
+{
+public:
+    explicit SlicesSendMsg(std::vector<SendableMsg::Ptr> slices)
+        : mSlices(std::move(slices)),
+          mSize(0)
+    {
+        for (const auto& slice : mSlices)
+        {
+            mSize += slice->size();
+        }
+    }
+
+    const void* data() override
+    {
+        return nullptr;
+    }
+    size_t size() override
+    {
+        return mSize;
+    }
+    SlicesSendMsg* asSlicesMsg() override
+    {
+        return this;
+    }
+
+    const std::vector<SendableMsg::Ptr>& slices() const
+    {
+        return mSlices;
+    }
+
+    // 从消息的第offset字节开始, 依次以(const char* data, size_t len)调用callback, 跳过空片段.
+    // callback返回false时停止
+    template<typename Callback>
+    void forEachSlice(size_t offset, Callback&& callback) const
+    {
+        for (const auto& slice : mSlices)
+        {
+            const auto sliceSize = slice->size();
+            if (offset >= sliceSize)
+            {
+                offset -= sliceSize;
+                continue;
+            }
+
+            const auto skip = offset;
+            offset = 0;
+            if (!callback(static_cast<const char*>(slice->data()) + skip, sliceSize - skip))
+            {
+                break;
+            }
+        }
+    }
+
+private:
+    const std::vector<SendableMsg::Ptr> mSlices;
+    size_t mSize;
+};
+
+inline SendableMsg::Ptr MakeSlicesMsg(std::vector<SendableMsg::Ptr> slices)
+{
+    return std::make_shared<SlicesSendMsg>(std::move(slices));
+}
+
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+// 文件区间消息: 发送fd中从offset开始的length字节, 非SSL连接由内核通过sendfile直接发送, 不经过用户态内存.
+// data()返回nullptr, 发送期间文件内容(长度)不能被修改
+class FileSendMsg : public SendableMsg
+{
+public:
+    // closeFD为true时消息析构时关闭fd
+    FileSendMsg(int fd, off_t offset, size_t length, bool closeFD)
+        : mFD(fd),
+          mOffset(offset),
+          mLength(length),
+          mCloseFD(closeFD)
+    {}
+
+    ~FileSendMsg() override
+    {
+        if (mCloseFD)
+        {
+            ::close(mFD);
+        }
+    }
+
+    const void* data() override
+    {
+        return nullptr;
+    }
+    size_t size() override
+    {
+        return mLength;
+    }
+    FileSendMsg* asFileMsg() override
+    {
+        return this;
+    }
+
+    int fd() const
+    {
+        return mFD;
+    }
+    off_t offset() const
+    {
+        return mOffset;
+    }
+
+private:
+    const int mFD;
+    const off_t mOffset;
+    const size_t mLength;
+    const bool mCloseFD;
+};
+
+inline SendableMsg::Ptr MakeFileMsg(int fd, off_t offset, size_t length, bool closeFD = false)
+{
+    return std::make_shared<FileSendMsg>(fd, offset, length, closeFD);
+}
+#endif
+
 }}// namespace brynet::net
\ No newline at end of file
@@ -75,6 +75,12 @@ public:
         return brynet::net::base::SocketNonblock(mFD);
     }
 
+    // 是否在accept时已经设置为非阻塞
+    bool isNonblock() const
+    {
+        return mNonblock;
+    }
+
     void setSendSize(int sdSize) const
     {
         brynet::net::base::SocketSetSendSize(mFD, sdSize);
@@ -87,7 +93,17 @@ public:
 
     std::string getRemoteIP() const
     {
-        return brynet::net::base::GetIPOfSocket(mFD);
+        return brynet::net::base::GetIPOfAddr(getRemoteAddr());
+    }
+
+    // 对端地址, 由accept得到的socket直接使用accept返回的地址, 不再调用getpeername
+    struct sockaddr_in6 getRemoteAddr() const
+    {
+        if (mHasRemoteAddr)
+        {
+            return mRemoteAddr;
+        }
+        return brynet::net::base::getPeerAddr(mFD);
     }
 
     bool isServerSide() const
@@ -98,7 +114,10 @@ public:
 protected:
     TcpSocket(BrynetSocketFD fd, bool serverSide)
         : mFD(fd),
-          mServerSide(serverSide)
+          mServerSide(serverSide),
+          mNonblock(false),
+          mHasRemoteAddr(false),
+          mRemoteAddr(sockaddr_in6())
     {
     }
 
@@ -115,8 +134,12 @@ protected:
 private:
     const BrynetSocketFD mFD;
     const bool mServerSide;
+    bool mNonblock;
+    bool mHasRemoteAddr;
+    struct sockaddr_in6 mRemoteAddr;
 
     friend class TcpConnection;
+    friend class ListenSocket;
 };
 
 class EintrError : public std::exception
@@ -158,11 +181,48 @@ public:
 public:
     TcpSocket::Ptr accept()
     {
-        const auto clientFD = brynet::net::base::Accept(mFD, nullptr, nullptr);
+        int errorCode = 0;
+        auto socket = doAccept(errorCode, false);
+        if (socket == nullptr)
+        {
+            if (errorCode == EINTR)
+            {
+                throw EintrError();
+            }
+            else
+            {
+                throw AcceptError(errorCode);
+            }
+        }
+
+        return socket;
+    }
+
+    // 不抛出异常的accept, 返回的socket已经是非阻塞的.
+    // 失败时(包括非阻塞的监听socket没有新连接)返回nullptr并设置errorCode
+    TcpSocket::Ptr tryAccept(int& errorCode)
+    {
+        return doAccept(errorCode, true);
+    }
+
+    BrynetSocketFD getFD() const
+    {
+        return mFD;
+    }
+
+private:
+    TcpSocket::Ptr doAccept(int& errorCode, bool nonblock)
+    {
+        struct sockaddr_in6 addr = sockaddr_in6();
+        auto addrLen = static_cast<socklen_t>(sizeof(addr));
+        const auto clientFD = nonblock
+                                      ? brynet::net::base::AcceptNonblock(mFD, (struct sockaddr*) &addr, &addrLen)
+                                      : brynet::net::base::Accept(mFD, (struct sockaddr*) &addr, &addrLen);
         if (clientFD == BRYNET_INVALID_SOCKET)
         {
+            errorCode = BRYNET_ERRNO;
 #if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
-            if (BRYNET_ERRNO == EMFILE)
+            if (errorCode == EMFILE)
             {
                 // Thanks libev and muduo.
                 // Read the section named "The special problem of
@@ -173,17 +233,14 @@ public:
                 mIdle = brynet::net::TcpSocket::Create(::open("/dev/null", O_RDONLY | O_CLOEXEC), true);
             }
 #endif
-            if (BRYNET_ERRNO == EINTR)
-            {
-                throw EintrError();
-            }
-            else
-            {
-                throw AcceptError(BRYNET_ERRNO);
-            }
+            return nullptr;
         }
 
-        return TcpSocket::Create(clientFD, true);
+        auto socket = TcpSocket::Create(clientFD, true);
+        socket->mNonblock = nonblock;
+        socket->mHasRemoteAddr = addrLen <= static_cast<socklen_t>(sizeof(addr));
+        socket->mRemoteAddr = addr;
+        return socket;
     }
 
 public:
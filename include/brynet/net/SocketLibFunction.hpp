@@ -81,6 +81,15 @@ static int SocketSetRecvSize(BrynetSocketFD fd, int rd_size)
     return ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, (const char*) &rd_size, sizeof(rd_size));
 }
 
+#ifdef BRYNET_PLATFORM_LINUX
+// 允许该socket使用MSG_ZEROCOPY发送
+inline bool SocketZeroCopy(BrynetSocketFD fd)
+{
+    const int flag = 1;
+    return ::setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, (const char*) &flag, sizeof(flag)) == 0;
+}
+#endif
+
 static int SocketSetReusePort(BrynetSocketFD fd)
 {
 #ifdef BRYNET_PLATFORM_WINDOWS
@@ -247,6 +256,15 @@ static std::string getIPString(const struct sockaddr* sa)
     return tmp;
 }
 
+inline std::string GetIPOfAddr(const struct sockaddr_in6& addr)
+{
+    if (addr.sin6_family != AF_INET && addr.sin6_family != AF_INET6)
+    {
+        return "";
+    }
+    return getIPString((const struct sockaddr*) &addr);
+}
+
 static std::string GetIPOfSocket(BrynetSocketFD fd)
 {
 #ifdef BRYNET_PLATFORM_WINDOWS
@@ -280,11 +298,46 @@ static int SocketSend(BrynetSocketFD fd, const char* buffer, int len)
     return transnum;
 }
 
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+// 把文件fd中从offset开始的最多len字节发送到socket, 返回值与send相同
+inline ssize_t SocketSendFile(BrynetSocketFD fd, int fileFD, off_t offset, size_t len)
+{
+#ifdef BRYNET_PLATFORM_LINUX
+    return ::sendfile(fd, fileFD, &offset, len);
+#else
+    auto sendLen = static_cast<off_t>(len);
+    const auto ret = ::sendfile(fileFD, fd, offset, &sendLen, nullptr, 0);
+    // 非阻塞socket上可能返回EAGAIN但已发送了部分数据
+    if (ret == 0 || (sendLen > 0 && (errno == EAGAIN || errno == EINTR)))
+    {
+        return static_cast<ssize_t>(sendLen);
+    }
+    return -1;
+#endif
+}
+#endif
+
 static BrynetSocketFD Accept(BrynetSocketFD listenSocket, struct sockaddr* addr, socklen_t* addrLen)
 {
     return ::accept(listenSocket, addr, addrLen);
 }
 
+// 新socket直接为非阻塞, Linux下由accept4一次完成(同时设置close-on-exec)
+inline BrynetSocketFD AcceptNonblock(BrynetSocketFD listenSocket, struct sockaddr* addr, socklen_t* addrLen)
+{
+#ifdef BRYNET_PLATFORM_LINUX
+    return ::accept4(listenSocket, addr, addrLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+    const auto fd = ::accept(listenSocket, addr, addrLen);
+    if (fd != BRYNET_INVALID_SOCKET && !SocketNonblock(fd))
+    {
+        SocketClose(fd);
+        return BRYNET_INVALID_SOCKET;
+    }
+    return fd;
+#endif
+}
+
 static struct sockaddr_in6 getPeerAddr(BrynetSocketFD sockfd)
 {
     struct sockaddr_in6 peeraddr = sockaddr_in6();
@@ -2,23 +2,31 @@
 
 #include <brynet/base/Any.hpp>
 #include <brynet/base/Buffer.hpp>
+#include <brynet/base/MPSCRingQueue.hpp>
+#include <brynet/base/MoveOnlyFunction.hpp>
 #include <brynet/base/Noexcept.hpp>
 #include <brynet/base/NonCopyable.hpp>
 #include <brynet/base/Packet.hpp>
 #include <brynet/base/Timer.hpp>
+#include <brynet/base/TokenBucket.hpp>
 #include <brynet/net/Channel.hpp>
 #include <brynet/net/EventLoop.hpp>
 #include <brynet/net/SSLHelper.hpp>
 #include <brynet/net/SendableMsg.hpp>
 #include <brynet/net/Socket.hpp>
 #include <brynet/net/SocketLibFunction.hpp>
+#include <brynet/net/detail/RingQueue.hpp>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cmath>
 #include <cstring>
 #include <deque>
 #include <functional>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <type_traits>
 
 #ifdef BRYNET_USE_OPENSSL
@@ -46,15 +54,18 @@ public:
     using EnterCallback = std::function<void(Ptr)>;
     using DataCallback = std::function<void(brynet::base::BasePacketReader&)>;
     using DisconnectedCallback = std::function<void(Ptr)>;
-    using PacketSendedCallback = std::function<void(void)>;
+    // 内联缓冲区只保留16字节(足够捕获一个shared_ptr), 使跨线程send投递的异步函数能够放入UserFunctor的内联缓冲区
+    using PacketSendedCallback = brynet::base::MoveOnlyFunction<void(void), 16>;
     using HighWaterCallback = std::function<void(void)>;
+    using LowWaterCallback = std::function<void(void)>;
 
 public:
     Ptr static Create(TcpSocket::Ptr socket,
                       size_t maxRecvBufferSize,
                       EnterCallback&& enterCallback,
                       const EventLoop::Ptr& eventLoop,
-                      const SSLHelper::Ptr& sslHelper = nullptr)
+                      const SSLHelper::Ptr& sslHelper = nullptr,
+                      const std::string& sslServerName = std::string())
     {
         class make_shared_enabler : public TcpConnection
         {
@@ -80,6 +91,7 @@ public:
 #ifdef BRYNET_USE_OPENSSL
         if (sslHelper != nullptr)
         {
+            session->mSSLHelper = sslHelper;
             if (isServerSide)
             {
                 if (sslHelper->getOpenSSLCTX() == nullptr ||
@@ -90,7 +102,7 @@ public:
             }
             else
             {
-                if (!session->initConnectSSL())
+                if (!session->initConnectSSL(sslHelper->getOpenSSLCTX(), sslServerName))
                 {
                     throw std::runtime_error("init ssl failed");
                 }
@@ -124,10 +136,7 @@ public:
         }
         else
         {
-            auto sharedThis = shared_from_this();
-            mEventLoop->runAsyncFunctor([sharedThis, msg, callback, this]() mutable {
-                sendInLoop(msg, std::move(callback));
-            });
+            pushInbound(InboundTask{msg, std::move(callback)});
         }
     }
 
@@ -156,8 +165,7 @@ public:
     {
         verifyArgType(cb, &Callback::operator());
 
-        auto sharedThis = shared_from_this();
-        mEventLoop->runAsyncFunctor([sharedThis, cb, this]() mutable {
+        runInLoop([cb, this]() mutable {
             mDataCallback = cb;
             processRecvMessage();
         });
@@ -165,8 +173,7 @@ public:
 
     void setDisConnectCallback(DisconnectedCallback&& cb)
     {
-        auto sharedThis = shared_from_this();
-        mEventLoop->runAsyncFunctor([sharedThis, cb, this]() mutable {
+        runInLoop([cb, this]() mutable {
             mDisConnectCallback = std::move(cb);
         });
     }
@@ -174,8 +181,7 @@ public:
     /* if checkTime is zero, will cancel check heartbeat */
     void setHeartBeat(std::chrono::nanoseconds checkTime)
     {
-        auto sharedThis = shared_from_this();
-        mEventLoop->runAsyncFunctor([sharedThis, checkTime, this]() {
+        runInLoop([checkTime, this]() {
             if (mTimer.lock() != nullptr)
             {
                 mTimer.lock()->cancel();
@@ -187,19 +193,129 @@ public:
         });
     }
 
+    // 长度小于threshold且没有发送完成回调的消息拷贝到连接的合并缓冲区中, 与相邻的短消息一起发送,
+    // 较大的消息仍然只引用不拷贝. threshold为0表示关闭
+    void setCoalesceThreshold(size_t threshold)
+    {
+        runInLoop([this, threshold]() {
+            mCoalesceThreshold = threshold;
+        });
+    }
+
+    // 待发送字节数超过size时回调一次, 之后直到低水位回调触发(待发送字节数降到低水位)才会再次回调
     void setHighWaterCallback(HighWaterCallback cb, size_t size)
     {
-        auto sharedThis = shared_from_this();
-        mEventLoop->runAsyncFunctor([=]() mutable {
+        runInLoop([=]() mutable {
             mHighWaterCallback = std::move(cb);
             mHighWaterSize = size;
         });
     }
 
+    // 触发过高水位回调后, 待发送字节数降到不超过size时回调一次
+    void setLowWaterCallback(LowWaterCallback cb, size_t size)
+    {
+        runInLoop([=]() mutable {
+            mLowWaterCallback = std::move(cb);
+            mLowWaterSize = size;
+        });
+    }
+
+    // (线程安全)已进入发送队列且尚未发送完成的字节数, 不包含其他线程调用send后尚未被loop线程处理的消息
+    size_t getPendingSendBytes() const
+    {
+        return mSendingMsgSize.load(std::memory_order_relaxed);
+    }
+
+    // 限制本连接的发送速率(字节/秒), bytesPerSecond为0表示不限速, burst为0时取bytesPerSecond.
+    // 令牌不足时暂缓发送而不丢弃数据, 消息留在发送队列中(计入待发送字节数, 会触发高/低水位回调), 令牌恢复后由定时器继续发送
+    void setSendRateLimit(size_t bytesPerSecond, size_t burst = 0)
+    {
+        runInLoop([this, bytesPerSecond, burst]() {
+            mSendRateLimiter.setRate(bytesPerSecond, burst);
+        });
+    }
+
+    // 与其他连接共用的限速器(例如TcpService的总限速), 与setSendRateLimit同时生效
+    void setSharedSendRateLimiter(brynet::base::TokenBucket::Ptr limiter)
+    {
+        runInLoop([this, limiter]() {
+            mSharedSendRateLimiter = limiter;
+        });
+    }
+
+    // (在loop线程中调用)SSL连接握手完成后是否已由内核(kTLS)负责加密发送, 此时发送与非SSL连接一样使用writev/sendfile
+    bool isKtlsSend() const
+    {
+#ifdef BRYNET_USE_OPENSSL
+        return mKtlsSend;
+#else
+        return false;
+#endif
+    }
+
+    // (Linux, 非SSL连接)长度不小于threshold的消息使用MSG_ZEROCOPY发送, 内核直接引用消息内存而不拷贝.
+    // 内核通知不再引用该内存后才释放消息并调用发送完成回调. threshold为0表示关闭, 内核不支持时仍为普通发送
+    void setZeroCopyThreshold(size_t threshold)
+    {
+#ifdef BRYNET_PLATFORM_LINUX
+        runInLoop([this, threshold]() {
+            if (mAlreadyClose)
+            {
+                return;
+            }
+            if (threshold > 0 && !mZeroCopyEnabled)
+            {
+                mZeroCopyEnabled = brynet::net::base::SocketZeroCopy(mSocket->getFD());
+            }
+            mZeroCopyThreshold = mZeroCopyEnabled ? threshold : 0;
+        });
+#else
+        (void) threshold;
+#endif
+    }
+
+    // 暂停从socket读取数据(不再调用recv, 也不再回调数据处理函数), 依靠TCP流量控制让对端暂停发送
+    void pauseRead()
+    {
+        runInLoop([this]() {
+            if (mReadPaused || mAlreadyClose)
+            {
+                return;
+            }
+            mReadPaused = true;
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+            recheckEvent();
+#endif
+        });
+    }
+
+    // 恢复读取, 先把暂停期间接收缓冲区中尚未处理的数据交给数据处理函数
+    void resumeRead()
+    {
+        runInLoop([this]() {
+            if (!mReadPaused || mAlreadyClose)
+            {
+                return;
+            }
+            mReadPaused = false;
+
+            processRecvMessage();
+            if (mReadPaused || mAlreadyClose)
+            {
+                return;
+            }
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+            recheckEvent();
+#endif
+            // 边缘触发不会补发暂停期间到达的数据(以及SSL内部已缓存的数据), 主动读取一次
+            recv();
+        });
+    }
+
     void postShrinkReceiveBuffer()
     {
-        auto sharedThis = shared_from_this();
-        mEventLoop->runAsyncFunctor([sharedThis, this]() {
+        runInLoop([this]() {
+            auto sharedThis = shared_from_this();
             mEventLoop->runFunctorAfterLoop([sharedThis, this]() {
                 shrinkReceiveBuffer();
             });
@@ -208,16 +324,15 @@ public:
 
     void postDisConnect()
     {
-        auto sharedThis = shared_from_this();
-        mEventLoop->runAsyncFunctor([sharedThis, this]() {
+        runInLoop([this]() {
             procCloseInLoop();
         });
     }
 
     void postShutdown()
     {
-        auto sharedThis = shared_from_this();
-        mEventLoop->runAsyncFunctor([sharedThis, this]() {
+        runInLoop([this]() {
+            auto sharedThis = shared_from_this();
             mEventLoop->runFunctorAfterLoop([sharedThis, this]() {
                 procShutdownInLoop();
             });
@@ -226,6 +341,10 @@ public:
 
     const std::string& getIP() const
     {
+        // 第一次使用时才把对端地址转换为字符串
+        std::call_once(mIPOnce, [this]() {
+            mIP = brynet::net::base::GetIPOfAddr(mRemoteAddr);
+        });
         return mIP;
     }
 
@@ -240,24 +359,46 @@ protected:
         mOvlSend(port::Win::OverlappedType::OverlappedSend),
         mPostClose(false),
 #endif
-        mIP(socket->getRemoteIP()),
+        mRemoteAddr(socket->getRemoteAddr()),
         mSocket(std::move(socket)),
         mEventLoop(std::move(eventLoop)),
         mAlreadyClose(false),
         mMaxRecvBufferSize(maxRecvBufferSize),
         mSendingMsgSize(0),
+        mInboundTasks(nullptr),
+        mInboundScheduled(false),
+        mCoalesceThreshold(0),
         mEnterCallback(std::move(enterCallback)),
-        mHighWaterSize(0)
+        mHighWaterSize(0),
+        mLowWaterSize(0),
+        mAboveHighWater(false)
     {
         mRecvData = false;
         mCheckTime = std::chrono::steady_clock::duration::zero();
         mIsPostFlush = false;
+        mSendPaced = false;
+        mShutdownAfterPaced = false;
 
         mCanWrite = true;
+        mReadPaused = false;
+        mEventLoop->mConnectionNum.fetch_add(1, std::memory_order_relaxed);
 
 #ifdef BRYNET_PLATFORM_WINDOWS
         mPostRecvCheck = false;
         mPostWriteCheck = false;
+#else
+        mWriteInterest = false;
+        mSendWindowHead = 0;
+        mSendWindowBytes = 0;
+        mSendWindowSeq = 0;
+        mSendWindowOffset = 0;
+        mSendWindowZeroCopy = false;
+#endif
+#ifdef BRYNET_PLATFORM_LINUX
+        mZeroCopyEnabled = false;
+        mZeroCopyThreshold = 0;
+        mZeroCopyNextSeq = 0;
+        mZeroCopyDoneSeq = 0;
 #endif
         growRecvBuffer();
 
@@ -265,6 +406,9 @@ protected:
         mSSLCtx = nullptr;
         mSSL = nullptr;
         mIsHandsharked = false;
+        mKtlsSend = false;
+        mSSLPendingWritePtr = nullptr;
+        mSSLPendingWriteLen = 0;
 #endif
     }
 
@@ -287,9 +431,127 @@ protected:
         {
             mTimer.lock()->cancel();
         }
+
+        delete mInboundTasks.load(std::memory_order_acquire);
+        mEventLoop->mConnectionNum.fetch_sub(1, std::memory_order_relaxed);
     }
 
 private:
+    struct PendingPacket
+    {
+        SendableMsg::Ptr data;
+        size_t left;
+        PacketSendedCallback mCompleteCallback;
+        // data为连接自己的合并缓冲区(CoalesceSendMsg)
+        bool coalesced;
+    };
+
+    // 合并缓冲区, 只在所属连接的loop线程中追加数据
+    class CoalesceSendMsg : public SendableMsg
+    {
+    public:
+        // 预先分配全部容量, 追加数据时不会移动已在发送中的内存
+        CoalesceSendMsg(std::string&& buffer, size_t capacity)
+            : mBuffer(std::move(buffer))
+        {
+            mBuffer.reserve(capacity);
+        }
+
+        const void* data() override
+        {
+            return static_cast<const void*>(mBuffer.data());
+        }
+        size_t size() override
+        {
+            return mBuffer.size();
+        }
+
+        void append(const char* buffer, size_t len)
+        {
+            mBuffer.append(buffer, len);
+        }
+        std::string& buffer()
+        {
+            return mBuffer;
+        }
+
+    private:
+        std::string mBuffer;
+    };
+
+    // 其他线程调用send投递的消息, msg为空时callback为投递的连接操作
+    struct InboundTask
+    {
+        SendableMsg::Ptr msg;
+        PacketSendedCallback callback;
+    };
+    using InboundQueue = brynet::base::MPSCRingQueue<InboundTask>;
+    static const size_t sInboundQueueCapacity = 32;
+
+    // 在loop线程中执行连接操作. 其他线程调用时与send使用同一个队列,
+    // 保证同一线程先send再投递的操作(例如postShutdown)在这些消息之后执行
+    template<typename F>
+    void runInLoop(F&& functor)
+    {
+        if (mEventLoop->isInLoopThread())
+        {
+            functor();
+        }
+        else
+        {
+            pushInbound(InboundTask{nullptr, std::forward<F>(functor)});
+        }
+    }
+
+    // 首次跨线程投递时才创建入站队列, 只在loop线程中使用的连接不占用其内存
+    InboundQueue& inboundTasks()
+    {
+        auto queue = mInboundTasks.load(std::memory_order_acquire);
+        if (queue == nullptr)
+        {
+            auto created = new InboundQueue(sInboundQueueCapacity);
+            if (mInboundTasks.compare_exchange_strong(queue, created, std::memory_order_acq_rel))
+            {
+                queue = created;
+            }
+            else
+            {
+                delete created;
+            }
+        }
+        return *queue;
+    }
+
+    void pushInbound(InboundTask&& task)
+    {
+        // 环形队列的位置预先分配, 投递不分配内存; 积压超过容量时进入队列的溢出缓冲
+        inboundTasks().push(std::move(task));
+        // 队列由空变为非空时才投递一次处理函数, 之后的任务直接追加到队列中, 由同一次处理取出
+        if (!mInboundScheduled.exchange(true, std::memory_order_acq_rel))
+        {
+            auto sharedThis = shared_from_this();
+            mEventLoop->runAsyncFunctor([sharedThis, this]() {
+                drainInboundTasks();
+            });
+        }
+    }
+
+    void drainInboundTasks()
+    {
+        // 先清除标记再取出: 之后投递的任务要么在本次被取出, 要么会重新投递处理函数
+        mInboundScheduled.exchange(false, std::memory_order_acq_rel);
+        mInboundTasks.load(std::memory_order_acquire)->popAll([this](InboundTask& task) {
+            if (task.msg == nullptr)
+            {
+                task.callback();
+            }
+            else
+            {
+                sendInLoop(task.msg, std::move(task.callback));
+            }
+        });
+    }
+
     void sendInLoop(const SendableMsg::Ptr& msg,
                     PacketSendedCallback&& callback = nullptr)
     {
@@ -299,20 +561,106 @@ private:
         }
 
         const auto len = msg->size();
-        mSendingMsgSize += len;
-        mSendList.emplace_back(PendingPacket{
-                msg,
-                len,
-                std::move(callback)});
+        increaseSendingMsgSize(len);
+        if (!coalesceInLoop(msg, len, callback))
+        {
+            mSendList.push_back(PendingPacket{
+                    msg,
+                    len,
+                    std::move(callback),
+                    false});
+        }
         runAfterFlush();
 
-        if (mSendingMsgSize > mHighWaterSize &&
-            mHighWaterCallback != nullptr)
+        if (!mAboveHighWater &&
+            mHighWaterCallback != nullptr &&
+            getPendingSendBytes() > mHighWaterSize)
         {
+            mAboveHighWater = true;
             mHighWaterCallback();
         }
     }
 
+    // 把短消息追加到发送队列末尾的合并缓冲区, 多个短消息只占用一个iovec.
+    // 带有发送完成回调的消息以及文件区间/多片段消息不合并
+    bool coalesceInLoop(const SendableMsg::Ptr& msg,
+                        size_t len,
+                        const PacketSendedCallback& callback)
+    {
+        if (len >= mCoalesceThreshold || callback != nullptr || msg->data() == nullptr)
+        {
+            return false;
+        }
+
+        static const size_t COALESCE_CHUNK_SIZE = 64 * 1024;
+        if (mSendList.empty() ||
+            !mSendList.back().coalesced ||
+            mSendList.back().data->size() + len > COALESCE_CHUNK_SIZE)
+        {
+            auto chunk = std::make_shared<CoalesceSendMsg>(std::move(mCoalesceSpareBuffer), COALESCE_CHUNK_SIZE);
+            mCoalesceSpareBuffer = std::string();
+            mSendList.push_back(PendingPacket{
+                    chunk,
+                    0,
+                    nullptr,
+                    true});
+        }
+
+        auto& packet = mSendList.back();
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+        if (mSendWindowSeq == mSendList.tailSeq())
+        {
+            // 合并缓冲区已全部加入iovec窗口, 新追加的数据需要重新加入
+            mSendWindowSeq = mSendList.tailSeq() - 1;
+            mSendWindowOffset = packet.data->size();
+        }
+#endif
+        static_cast<CoalesceSendMsg*>(packet.data.get())->append(static_cast<const char*>(msg->data()), len);
+        packet.left += len;
+        return true;
+    }
+
+    // 消息已全部发送(零拷贝消息则是内核已不再引用其内存)
+    void finishPacket(PendingPacket& packet)
+    {
+        if (packet.mCompleteCallback != nullptr)
+        {
+            pedingCallbacks.push_back(std::move(packet.mCompleteCallback));
+        }
+        decreaseSendingMsgSize(packet.data->size());
+        if (mAboveHighWater && getPendingSendBytes() <= mLowWaterSize)
+        {
+            // 在此消息的完成回调之后调用低水位回调
+            mAboveHighWater = false;
+            pedingCallbacks.push_back([this]() {
+                if (mLowWaterCallback != nullptr)
+                {
+                    mLowWaterCallback();
+                }
+            });
+        }
+        if (packet.coalesced && mCoalesceSpareBuffer.capacity() == 0)
+        {
+            // 保留一个合并缓冲区供下次复用
+            mCoalesceSpareBuffer = std::move(static_cast<CoalesceSendMsg*>(packet.data.get())->buffer());
+            mCoalesceSpareBuffer.clear();
+        }
+    }
+
+    // 只在loop线程中修改, 其他线程通过getPendingSendBytes读取
+    void increaseSendingMsgSize(size_t len)
+    {
+        mSendingMsgSize.store(mSendingMsgSize.load(std::memory_order_relaxed) + len,
+                              std::memory_order_relaxed);
+        mEventLoop->increasePendingSendBytes(len);
+    }
+    void decreaseSendingMsgSize(size_t len)
+    {
+        mSendingMsgSize.store(mSendingMsgSize.load(std::memory_order_relaxed) - len,
+                              std::memory_order_relaxed);
+        mEventLoop->decreasePendingSendBytes(len);
+    }
+
     void growRecvBuffer()
     {
         if (mRecvBuffer == nullptr)
@@ -373,8 +721,8 @@ private:
             return false;
         }
 
-        if (!brynet::net::base::SocketNonblock(mSocket->getFD()) ||
-            !mEventLoop->linkChannel(mSocket->getFD(), this))
+        if ((!mSocket->isNonblock() && !brynet::net::base::SocketNonblock(mSocket->getFD())) ||
+            !mEventLoop->linkChannel(mSocket->getFD(), this, false))
         {
             return false;
         }
@@ -412,24 +760,38 @@ private:
         }
 
         mSSL = SSL_new(ctx);
+        SSL_set_accept_state(mSSL);
+        setSSLWriteMode();
         if (SSL_set_fd(mSSL, mSocket->getFD()) != 1)
         {
             ERR_print_errors_fp(stdout);
             ::fflush(stdout);
             return false;
         }
+        enableKtls();
 
         return true;
     }
-    bool initConnectSSL()
+    // sharedCtx为SSLHelper::initClientSSL创建的共用SSL_CTX, 为nullptr时本连接单独创建一个.
+    // serverName非空时用于SNI以及证书主机名校验
+    bool initConnectSSL(SSL_CTX* sharedCtx, const std::string& serverName)
     {
-        if (mSSLCtx != nullptr)
+        if (mSSL != nullptr)
         {
             return false;
         }
 
-        mSSLCtx = SSL_CTX_new(SSLv23_client_method());
-        mSSL = SSL_new(mSSLCtx);
+        if (sharedCtx == nullptr)
+        {
+            mSSLCtx = SSL_CTX_new(SSLv23_client_method());
+            mSSL = SSL_new(mSSLCtx);
+        }
+        else
+        {
+            mSSL = SSL_new(sharedCtx);
+        }
+        SSL_set_connect_state(mSSL);
+        setSSLWriteMode();
 
         if (SSL_set_fd(mSSL, mSocket->getFD()) != 1)
         {
@@ -437,9 +799,43 @@ private:
             ::fflush(stdout);
             return false;
         }
+        if (!serverName.empty() &&
+            (SSL_set_tlsext_host_name(mSSL, serverName.c_str()) != 1 ||
+             SSL_set1_host(mSSL, serverName.c_str()) != 1))
+        {
+            return false;
+        }
+        if (sharedCtx != nullptr)
+        {
+            // 按(主机, 端口)恢复之前与同一上游建立的会话, 新会话由SSLHelper在回调中保存
+            mSSLSessionKey = (serverName.empty() ? getIP() : serverName) + ":" +
+                             std::to_string(ntohs(mRemoteAddr.sin6_port));
+            SSL_set_app_data(mSSL, &mSSLSessionKey);
+            const auto session = mSSLHelper->getClientSession(mSSLSessionKey);
+            if (session != nullptr)
+            {
+                SSL_set_session(mSSL, session);
+                SSL_SESSION_free(session);
+            }
+        }
+        enableKtls();
 
         return true;
     }
+
+    // WANT_WRITE后的重试可能使用连接自己保存的数据副本, 允许重试时缓冲区地址改变
+    void setSSLWriteMode()
+    {
+        SSL_set_mode(mSSL, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    }
+
+    // 请求OpenSSL在握手完成后把加密交给内核(kTLS), 内核不支持(例如未加载tls模块)或算法不支持时仍由OpenSSL加密
+    void enableKtls()
+    {
+#if defined BRYNET_PLATFORM_LINUX && defined SSL_OP_ENABLE_KTLS
+        SSL_set_options(mSSL, SSL_OP_ENABLE_KTLS);
+#endif
+    }
 #endif
 
     void pingCheck()
@@ -497,12 +893,16 @@ private:
             return;
         }
 #endif
+        if (mReadPaused)
+        {
+            return;
+        }
 
         do
         {
             recv();
             adjustReceiveBuffer();
-        } while (willClose && !mAlreadyClose && mRecvBuffer != nullptr && buffer_getwritevalidcount(mRecvBuffer.get()) > 0);
+        } while (willClose && !mAlreadyClose && !mReadPaused && mRecvBuffer != nullptr && buffer_getwritevalidcount(mRecvBuffer.get()) > 0);
     }
 
     void canSend() override
@@ -522,6 +922,12 @@ private:
         {
             return;
         }
+
+        bool spurious = mSendList.empty();
+#ifdef BRYNET_USE_OPENSSL
+        spurious = spurious && (mSSL == nullptr || mIsHandsharked);
+#endif
+        mEventLoop->mStats.recordSendEvent(spurious);
 #endif
         mCanWrite = true;
 
@@ -532,6 +938,12 @@ private:
         }
 #endif
 
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+        if (mSendList.empty())
+        {
+            setWriteInterest(false);
+        }
+#endif
         runAfterFlush();
     }
 
@@ -599,6 +1011,8 @@ private:
         {
             mPostWriteCheck = true;
         }
+#elif defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+        setWriteInterest(true);
 #endif
         return check_ret;
     }
@@ -630,7 +1044,13 @@ private:
         const bool notInSSL = false;
 #endif
 
-        while (true)
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+        // 接收缓冲区满时先就地处理消息腾出空间继续读取, 超过次数后才重新检测事件, 让出loop给其他连接
+        const int maxProcessWhenFull = 8;
+        int processWhenFull = 0;
+#endif
+
+        while (!mReadPaused)
         {
             adjustReceiveBuffer();
 
@@ -640,8 +1060,35 @@ private:
 #ifdef BRYNET_PLATFORM_WINDOWS
                 checkRead();
 #elif defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+                const auto readable = buffer_getreadvalidcount(mRecvBuffer.get());
+                if (processWhenFull < maxProcessWhenFull)
+                {
+                    processWhenFull++;
+                    processRecvMessage();
+                    if (mAlreadyClose || mRecvBuffer == nullptr)
+                    {
+                        return;
+                    }
+                    if (buffer_getreadvalidcount(mRecvBuffer.get()) < readable)
+                    {
+                        continue;
+                    }
+                }
                 //force recheck IN-OUT Event
                 recheckEvent();
+#ifdef BRYNET_USE_OPENSSL
+                // OpenSSL内部已缓存的数据不会再触发可读事件, 让出loop后继续读取
+                if (mSSL != nullptr && SSL_has_pending(mSSL))
+                {
+                    auto sharedThis = shared_from_this();
+                    mEventLoop->runFunctorAfterLoop([sharedThis, this]() {
+                        if (!mAlreadyClose)
+                        {
+                            recv();
+                        }
+                    });
+                }
+#endif
 #endif
                 break;
             }
@@ -716,24 +1163,126 @@ private:
 
     void flush()
     {
+        if (mSendPaced)
+        {
+            // 等待限速定时器
+            return;
+        }
+        const auto budget = sendBudget();
+        if (budget == 0 && !hasPendingSSLWrite())
+        {
+            if (!mSendList.empty() && mCanWrite)
+            {
+                paceSend();
+            }
+            return;
+        }
+
 #ifdef BRYNET_PLATFORM_WINDOWS
-        normalFlush();
+        normalFlush(budget);
 #elif defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
 #ifdef BRYNET_USE_OPENSSL
-        if (mSSL != nullptr)
+        // 内核负责加密发送时, 明文可以直接writev/sendfile到socket
+        if (mSSL != nullptr && !mKtlsSend)
         {
-            normalFlush();
+            normalFlush(budget);
         }
         else
         {
-            quickFlush();
+            quickFlush(budget);
         }
 #else
-        quickFlush();
+        quickFlush(budget);
 #endif
+        if (mSendList.empty())
+        {
+            setWriteInterest(false);
+        }
 #endif
+        // 限速时仍可写却没有发完, 说明本次令牌已用完
+        if (budget != (std::numeric_limits<size_t>::max)() && !mSendList.empty() && mCanWrite)
+        {
+            paceSend();
+        }
     }
-    void normalFlush()
+
+    // SSL_write返回WANT_WRITE后必须用相同的数据重试, 重试不受限速令牌限制
+    bool hasPendingSSLWrite() const
+    {
+#ifdef BRYNET_USE_OPENSSL
+        return mSSLPendingWriteLen > 0;
+#else
+        return false;
+#endif
+    }
+
+    bool sendRateLimited() const
+    {
+        return !mSendRateLimiter.unlimited() ||
+               (mSharedSendRateLimiter != nullptr && !mSharedSendRateLimiter->unlimited());
+    }
+
+    // 本次flush最多可以写出的字节数, 取本连接与共享限速器可用令牌的较小值
+    size_t sendBudget() const
+    {
+        if (!sendRateLimited())
+        {
+            return (std::numeric_limits<size_t>::max)();
+        }
+        const auto now = brynet::base::TokenBucket::Clock::now();
+        auto budget = mSendRateLimiter.available(now);
+        if (mSharedSendRateLimiter != nullptr)
+        {
+            budget = std::min(budget, mSharedSendRateLimiter->available(now));
+        }
+        return budget;
+    }
+
+    void consumeSendBudget(size_t len)
+    {
+        if (!sendRateLimited())
+        {
+            return;
+        }
+        const auto now = brynet::base::TokenBucket::Clock::now();
+        mSendRateLimiter.consume(len, now);
+        if (mSharedSendRateLimiter != nullptr)
+        {
+            mSharedSendRateLimiter->consume(len, now);
+        }
+    }
+
+    // 令牌不足时暂停发送, 等到能写出一批数据(PACING_BATCH_SIZE或剩余全部待发送字节)时由定时器恢复
+    void paceSend()
+    {
+        static const size_t PACING_BATCH_SIZE = 1024 * 4;
+        const auto now = brynet::base::TokenBucket::Clock::now();
+        const auto batch = std::min(getPendingSendBytes(), PACING_BATCH_SIZE);
+        auto wait = mSendRateLimiter.waitTime(batch, now);
+        if (mSharedSendRateLimiter != nullptr)
+        {
+            wait = std::max(wait, mSharedSendRateLimiter->waitTime(batch, now));
+        }
+
+        mSendPaced = true;
+        std::weak_ptr<TcpConnection> weakThis = shared_from_this();
+        mEventLoop->runAfter(wait, [weakThis]() {
+            const auto sharedThis = weakThis.lock();
+            if (sharedThis == nullptr)
+            {
+                return;
+            }
+            sharedThis->mSendPaced = false;
+            sharedThis->flush();
+            if (sharedThis->mShutdownAfterPaced && !sharedThis->mSendPaced)
+            {
+                sharedThis->mShutdownAfterPaced = false;
+                sharedThis->procShutdownInLoop();
+            }
+        });
+    }
+
+    void normalFlush(size_t budget)
     {
 #ifdef BRYNET_PLATFORM_WINDOWS
         static __declspec(thread) char* threadLocalSendBuf = nullptr;
@@ -754,23 +1303,79 @@ private:
 
         bool must_close = false;
 
-        while (!mSendList.empty() && mCanWrite)
+        while (!mSendList.empty() && mCanWrite && (budget > 0 || hasPendingSSLWrite()))
         {
             auto sendptr = threadLocalSendBuf;
             size_t wait_send_size = 0;
+            const auto fillLimit = std::min<size_t>(SENDBUF_SIZE, budget);
 
-            for (auto it = mSendList.begin(); it != mSendList.end(); ++it)
+#ifdef BRYNET_USE_OPENSSL
+            // 上次SSL_write未完成, 原样重试, 不重新填充
+            const bool retrySSLWrite = (mSSLPendingWriteLen > 0);
+            if (retrySSLWrite)
+            {
+                sendptr = const_cast<char*>(mSSLPendingWritePtr);
+                wait_send_size = mSSLPendingWriteLen;
+            }
+#else
+            const bool retrySSLWrite = false;
+#endif
+            for (size_t i = 0; !retrySSLWrite && i < mSendList.size(); i++)
             {
-                auto& packet = *it;
+                auto& packet = mSendList[i];
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+                const auto fileMsg = packet.data->asFileMsg();
+                if (fileMsg != nullptr)
+                {
+                    // SSL连接无法使用sendfile, 把文件内容读取到发送缓冲区
+                    const auto readLen = std::min<size_t>(packet.left, fillLimit - wait_send_size);
+                    if (readLen == 0)
+                    {
+                        break;
+                    }
+                    const auto offset = fileMsg->offset() + static_cast<off_t>(packet.data->size() - packet.left);
+                    const auto n = pread(fileMsg->fd(), sendptr + wait_send_size, readLen, offset);
+                    if (n <= 0)
+                    {
+                        must_close = true;
+                        break;
+                    }
+                    wait_send_size += static_cast<size_t>(n);
+                    if (static_cast<size_t>(n) < packet.left)
+                    {
+                        break;
+                    }
+                    continue;
+                }
+#endif
+                const auto slicesMsg = packet.data->asSlicesMsg();
+                if (slicesMsg != nullptr)
+                {
+                    // 把剩余片段依次拷贝到发送缓冲区, 放不下的部分留到下次发送
+                    size_t copyLen = 0;
+                    slicesMsg->forEachSlice(packet.data->size() - packet.left, [&](const char* buffer, size_t len) {
+                        const auto n = std::min<size_t>(len, fillLimit - wait_send_size);
+                        memcpy(sendptr + wait_send_size, buffer, n);
+                        wait_send_size += n;
+                        copyLen += n;
+                        return n == len;
+                    });
+                    if (copyLen < packet.left)
+                    {
+                        break;
+                    }
+                    continue;
+                }
+
                 auto packetLeftBuf = (char*) (packet.data->data()) + packet.data->size() - packet.left;
                 const auto packetLeftLen = packet.left;
 
-                if ((wait_send_size + packetLeftLen) > SENDBUF_SIZE)
+                if ((wait_send_size + packetLeftLen) > fillLimit)
                 {
-                    if (it == mSendList.begin())
+                    if (i == 0)
                     {
                         sendptr = packetLeftBuf;
-                        wait_send_size = packetLeftLen;
+                        wait_send_size = std::min(packetLeftLen, budget);
                     }
                     break;
                 }
@@ -779,7 +1384,7 @@ private:
                 wait_send_size += packetLeftLen;
             }
 
-            if (wait_send_size == 0)
+            if (must_close || wait_send_size == 0)
             {
                 break;
             }
@@ -804,6 +1409,10 @@ private:
                 if ((mSSL != nullptr && SSL_get_error(mSSL, send_retlen) == SSL_ERROR_WANT_WRITE) ||
                     (BRYNET_ERRNO == BRYNET_EWOULDBLOCK))
                 {
+                    if (mSSL != nullptr && !retrySSLWrite)
+                    {
+                        rememberSSLWrite(sendptr, wait_send_size, sendptr == threadLocalSendBuf);
+                    }
                     mCanWrite = false;
                     must_close = !checkWrite();
                 }
@@ -825,10 +1434,21 @@ private:
                 break;
             }
 
+#ifdef BRYNET_USE_OPENSSL
+            if (retrySSLWrite)
+            {
+                mSSLPendingWritePtr = nullptr;
+                mSSLPendingWriteLen = 0;
+                mSSLPendingWriteBuffer.clear();
+            }
+#endif
+            budget -= std::min(budget, static_cast<size_t>(send_retlen));
+            consumeSendBudget(static_cast<size_t>(send_retlen));
+
             auto tmp_len = static_cast<size_t>(send_retlen);
-            for (auto it = mSendList.begin(); it != mSendList.end();)
+            while (!mSendList.empty())
             {
-                auto& packet = *it;
+                auto& packet = mSendList.front();
                 if (packet.left > tmp_len)
                 {
                     packet.left -= tmp_len;
@@ -836,12 +1456,8 @@ private:
                 }
 
                 tmp_len -= packet.left;
-                if (packet.mCompleteCallback != nullptr)
-                {
-                    pedingCallbacks.push_back(std::move(packet.mCompleteCallback));
-                }
-                mSendingMsgSize -= packet.data->size();
-                it = mSendList.erase(it);
+                finishPacket(packet);
+                mSendList.pop_front();
             }
             for (auto&& callback : pedingCallbacks)
             {
@@ -862,39 +1478,107 @@ private:
             procCloseInLoop();
         }
     }
-#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
-    void quickFlush()
+#ifdef BRYNET_USE_OPENSSL
+    // 线程局部发送缓冲区会被同一线程的其他连接覆盖, 需要拷贝一份;
+    // 直接引用的消息内存在发送完成之前不会释放或改变
+    void rememberSSLWrite(const char* buffer, size_t len, bool copy)
     {
-#ifndef MAX_IOVEC
-        constexpr size_t MAX_IOVEC = 1024;
+        if (copy)
+        {
+            mSSLPendingWriteBuffer.assign(buffer, len);
+            buffer = mSSLPendingWriteBuffer.data();
+        }
+        mSSLPendingWritePtr = buffer;
+        mSSLPendingWriteLen = len;
+    }
 #endif
-
-        struct iovec iov[MAX_IOVEC];
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+    void quickFlush(size_t budget)
+    {
         bool must_close = false;
 
-        while (!mSendList.empty() && mCanWrite)
+        while (!mSendList.empty() && mCanWrite && budget > 0)
         {
-            size_t num = 0;
             size_t ready_send_len = 0;
-            for (const auto& p : mSendList)
+            int send_len = -1;
+            const auto& front = mSendList.front();
+            const auto fileMsg = front.data->asFileMsg();
+            if (fileMsg != nullptr)
             {
-                iov[num].iov_base = (void*) (static_cast<const char*>(p.data->data()) + p.data->size() - p.left);
-                iov[num].iov_len = p.left;
-                ready_send_len += p.left;
-
-                num++;
-                if (num >= MAX_IOVEC)
+                // 文件区间消息单独通过sendfile发送, 单次最多发送1GB
+                ready_send_len = std::min<size_t>(std::min<size_t>(front.left, 1024 * 1024 * 1024), budget);
+                const auto offset = fileMsg->offset() + static_cast<off_t>(front.data->size() - front.left);
+                send_len = static_cast<int>(brynet::net::base::SocketSendFile(mSocket->getFD(),
+                                                                               fileMsg->fd(),
+                                                                               offset,
+                                                                               ready_send_len));
+                if (send_len == 0)
                 {
+                    // 文件实际长度小于消息长度
+                    must_close = true;
                     break;
                 }
             }
-
-            if (num == 0)
+            else
             {
-                break;
-            }
+                fillSendWindow();
+                const auto iov = mSendWindow.data() + mSendWindowHead;
+                auto num = mSendWindow.size() - mSendWindowHead;
+                if (num == 0)
+                {
+                    break;
+                }
+                ready_send_len = mSendWindowBytes;
+
+                // 限速时临时截短窗口, 只写出budget字节
+                struct iovec* cutIov = nullptr;
+                size_t cutIovLen = 0;
+                if (ready_send_len > budget)
+                {
+                    size_t len = 0;
+                    num = 0;
+                    while (len + iov[num].iov_len < budget)
+                    {
+                        len += iov[num].iov_len;
+                        num++;
+                    }
+                    cutIov = &iov[num];
+                    cutIovLen = cutIov->iov_len;
+                    cutIov->iov_len = budget - len;
+                    num++;
+                    ready_send_len = budget;
+                }
 
-            const int send_len = writev(mSocket->getFD(), iov, static_cast<int>(num));
+#ifdef BRYNET_PLATFORM_LINUX
+                if (mSendWindowZeroCopy)
+                {
+                    struct msghdr msg;
+                    memset(&msg, 0, sizeof(msg));
+                    msg.msg_iov = iov;
+                    msg.msg_iovlen = num;
+                    send_len = static_cast<int>(sendmsg(mSocket->getFD(), &msg, MSG_ZEROCOPY));
+                    if (send_len > 0)
+                    {
+                        mZeroCopyNextSeq++;
+                    }
+                }
+                // ENOBUFS: 未完成的零拷贝通知过多(超过optmem限制), 本次改为普通发送
+                if (!mSendWindowZeroCopy || (send_len < 0 && BRYNET_ERRNO == ENOBUFS))
+                {
+                    send_len = writev(mSocket->getFD(), iov, static_cast<int>(num));
+                }
+#else
+                send_len = writev(mSocket->getFD(), iov, static_cast<int>(num));
+#endif
+                if (cutIov != nullptr)
+                {
+                    cutIov->iov_len = cutIovLen;
+                }
+                if (send_len > 0)
+                {
+                    consumeSendWindow(static_cast<size_t>(send_len));
+                }
+            }
             if (send_len <= 0)
             {
                 if (BRYNET_ERRNO == BRYNET_EWOULDBLOCK)
@@ -909,10 +1593,13 @@ private:
                 break;
             }
 
+            budget -= static_cast<size_t>(send_len);
+            consumeSendBudget(static_cast<size_t>(send_len));
+
             auto tmp_len = static_cast<size_t>(send_len);
-            for (auto it = mSendList.begin(); it != mSendList.end();)
+            while (!mSendList.empty())
             {
-                PendingPacket& b = *it;
+                PendingPacket& b = mSendList.front();
                 if (b.left > tmp_len)
                 {
                     b.left -= tmp_len;
@@ -920,12 +1607,17 @@ private:
                 }
 
                 tmp_len -= b.left;
-                if (b.mCompleteCallback != nullptr)
+#ifdef BRYNET_PLATFORM_LINUX
+                // 还有零拷贝发送未完成时, 消息(以及之后的消息, 保证回调顺序)等待内核通知后再释放
+                if (mZeroCopyDoneSeq != mZeroCopyNextSeq || !mZeroCopyWaitList.empty())
                 {
-                    pedingCallbacks.push_back(std::move(b.mCompleteCallback));
+                    mZeroCopyWaitList.push_back(ZeroCopyPacket{std::move(b), mZeroCopyNextSeq - 1});
+                    mSendList.pop_front();
+                    continue;
                 }
-                mSendingMsgSize -= b.data->size();
-                it = mSendList.erase(it);
+#endif
+                finishPacket(b);
+                mSendList.pop_front();
             }
             for (auto&& callback : pedingCallbacks)
             {
@@ -946,6 +1638,205 @@ private:
             procCloseInLoop();
         }
     }
+    // 把iovec窗口之后的消息追加到窗口中, 已在窗口中的消息不会重新构造.
+    // 窗口中剩余的iovec不少于一半时不追加, 使整理窗口的开销均摊到已发送的iovec上
+    void fillSendWindow()
+    {
+#ifndef MAX_IOVEC
+        constexpr size_t MAX_IOVEC = 1024;
+#endif
+        if (mSendWindowSeq < mSendList.headSeq())
+        {
+            // 窗口之前的消息已通过sendfile发送完毕
+            mSendWindowSeq = mSendList.headSeq();
+            mSendWindowOffset = 0;
+        }
+
+        const auto pending = mSendWindow.size() - mSendWindowHead;
+        if (mSendWindowSeq == mSendList.tailSeq() || pending >= MAX_IOVEC / 2)
+        {
+            return;
+        }
+        if (mSendWindowHead > 0)
+        {
+            mSendWindow.erase(mSendWindow.begin(), mSendWindow.begin() + mSendWindowHead);
+            mSendWindowHead = 0;
+        }
+#ifdef BRYNET_PLATFORM_LINUX
+        // 窗口中只放连续的同一类(是否零拷贝)内存消息
+        if (pending == 0)
+        {
+            mSendWindowZeroCopy = isZeroCopyPacket(mSendList.atSeq(mSendWindowSeq));
+        }
+#endif
+
+        while (mSendWindowSeq != mSendList.tailSeq() && mSendWindow.size() < MAX_IOVEC)
+        {
+            auto& p = mSendList.atSeq(mSendWindowSeq);
+            if (p.data->asFileMsg() != nullptr)
+            {
+                break;
+            }
+#ifdef BRYNET_PLATFORM_LINUX
+            if (isZeroCopyPacket(p) != mSendWindowZeroCopy)
+            {
+                break;
+            }
+#endif
+            const auto size = p.data->size();
+            const auto slicesMsg = p.data->asSlicesMsg();
+            if (slicesMsg != nullptr)
+            {
+                // 每个剩余片段占用一个iovec
+                slicesMsg->forEachSlice(mSendWindowOffset, [&](const char* buffer, size_t len) {
+                    if (mSendWindow.size() >= MAX_IOVEC)
+                    {
+                        return false;
+                    }
+                    pushSendWindow(buffer, len);
+                    mSendWindowOffset += len;
+                    return true;
+                });
+            }
+            else if (mSendWindowOffset < size)
+            {
+                pushSendWindow(static_cast<const char*>(p.data->data()) + mSendWindowOffset, size - mSendWindowOffset);
+                mSendWindowOffset = size;
+            }
+
+            if (mSendWindowOffset < size)
+            {
+                break;
+            }
+            mSendWindowSeq++;
+            mSendWindowOffset = 0;
+        }
+    }
+
+    void pushSendWindow(const char* buffer, size_t len)
+    {
+        struct iovec v;
+        v.iov_base = const_cast<char*>(buffer);
+        v.iov_len = len;
+        mSendWindow.push_back(v);
+        mSendWindowBytes += len;
+    }
+
+    // 从窗口头部移除已写出的len字节
+    void consumeSendWindow(size_t len)
+    {
+        mSendWindowBytes -= len;
+        while (len > 0)
+        {
+            auto& v = mSendWindow[mSendWindowHead];
+            if (v.iov_len > len)
+            {
+                v.iov_base = static_cast<char*>(v.iov_base) + len;
+                v.iov_len -= len;
+                break;
+            }
+            len -= v.iov_len;
+            mSendWindowHead++;
+        }
+    }
+
+    void resetSendWindow()
+    {
+        mSendWindow.clear();
+        mSendWindowHead = 0;
+        mSendWindowBytes = 0;
+        mSendWindowSeq = mSendList.tailSeq();
+        mSendWindowOffset = 0;
+    }
+#endif
+
+#ifdef BRYNET_PLATFORM_LINUX
+    // 合并缓冲区会继续追加数据并被复用, 不能零拷贝发送; kTLS不支持MSG_ZEROCOPY
+    bool isZeroCopyPacket(const PendingPacket& packet) const
+    {
+#ifdef BRYNET_USE_OPENSSL
+        if (mKtlsSend)
+        {
+            return false;
+        }
+#endif
+        return mZeroCopyThreshold > 0 && !packet.coalesced && packet.data->size() >= mZeroCopyThreshold;
+    }
+
+    void onErrorQueue() override
+    {
+        if (!mZeroCopyEnabled || mAlreadyClose)
+        {
+            return;
+        }
+
+        // 读取错误队列中的零拷贝完成通知, 每个通知表示序号区间[ee_info, ee_data]内的发送已不再引用用户内存
+        char control[128];
+        while (true)
+        {
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            if (recvmsg(mSocket->getFD(), &msg, MSG_ERRQUEUE) < 0)
+            {
+                break;
+            }
+
+            for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+            {
+                if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) &&
+                    !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))
+                {
+                    continue;
+                }
+                const auto err = reinterpret_cast<const struct sock_extended_err*>(CMSG_DATA(cmsg));
+                if (err->ee_errno == 0 && err->ee_origin == SO_EE_ORIGIN_ZEROCOPY)
+                {
+                    completeZeroCopy(err->ee_info, err->ee_data);
+                }
+            }
+        }
+
+        while (!mZeroCopyWaitList.empty() &&
+               static_cast<int32_t>(mZeroCopyWaitList.front().seq - mZeroCopyDoneSeq) < 0)
+        {
+            finishPacket(mZeroCopyWaitList.front().packet);
+            mZeroCopyWaitList.pop_front();
+        }
+        for (auto&& callback : pedingCallbacks)
+        {
+            callback();
+        }
+        pedingCallbacks.clear();
+    }
+
+    void completeZeroCopy(uint32_t lo, uint32_t hi)
+    {
+        // 通知通常按序到达, 乱序的区间暂存, 直到与已完成的序号连续
+        if (lo != mZeroCopyDoneSeq)
+        {
+            mZeroCopyDoneRanges.push_back(std::make_pair(lo, hi));
+            return;
+        }
+        mZeroCopyDoneSeq = hi + 1;
+
+        bool merged = true;
+        while (merged)
+        {
+            merged = false;
+            for (auto it = mZeroCopyDoneRanges.begin(); it != mZeroCopyDoneRanges.end(); ++it)
+            {
+                if (it->first == mZeroCopyDoneSeq)
+                {
+                    mZeroCopyDoneSeq = it->second + 1;
+                    mZeroCopyDoneRanges.erase(it);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
 #endif
 
     void onClose() override
@@ -956,6 +1847,14 @@ private:
         }
         mAlreadyClose = true;
 
+#ifdef BRYNET_USE_OPENSSL
+        if (mSSL != nullptr && mIsHandsharked)
+        {
+            // 尽力发送close_notify(不等待对端回应). 未发送就释放SSL时OpenSSL会把会话从缓存中移除, 之后无法再恢复
+            SSL_shutdown(mSSL);
+            ERR_clear_error();
+        }
+#endif
 #if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
         unregisterPollerEvent();
 #endif
@@ -985,8 +1884,16 @@ private:
         mDataCallback = nullptr;
         mDisConnectCallback = nullptr;
         mHighWaterCallback = nullptr;
+        mLowWaterCallback = nullptr;
         mRecvBuffer = nullptr;
         mSendList.clear();
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+        resetSendWindow();
+#endif
+#ifdef BRYNET_PLATFORM_LINUX
+        mZeroCopyWaitList.clear();
+#endif
+        decreaseSendingMsgSize(getPendingSendBytes());
     }
 
     void procCloseInLoop()
@@ -1023,6 +1930,12 @@ private:
 
     void procShutdownInLoop()
     {
+        if (mSendPaced && !mSendList.empty())
+        {
+            // 限速暂缓的数据发送后再关闭写端
+            mShutdownAfterPaced = true;
+            return;
+        }
         mCanWrite = false;
         if (mSocket != nullptr)
         {
@@ -1050,43 +1963,22 @@ private:
 #if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
     void recheckEvent()
     {
-#ifdef BRYNET_PLATFORM_LINUX
-        struct epoll_event ev = {0,
-                                 {
-                                     nullptr
-                                 }};
-        ev.events = EPOLLET | EPOLLIN | EPOLLOUT | EPOLLRDHUP;
-        ev.data.ptr = (Channel*) (this);
-        epoll_ctl(mEventLoop->getEpollHandle(), EPOLL_CTL_MOD, mSocket->getFD(), &ev);
-#elif defined BRYNET_PLATFORM_DARWIN
-        struct kevent ev[2];
-        memset(&ev, 0, sizeof(ev));
-        int n = 0;
-        EV_SET(&ev[n++], mSocket->getFD(), EVFILT_READ, EV_ENABLE, 0, 0, (Channel*) (this));
-        EV_SET(&ev[n++], mSocket->getFD(), EVFILT_WRITE, EV_ENABLE, 0, 0, (Channel*) (this));
-
-        struct timespec now = {0, 0};
-        kevent(mEventLoop->getKqueueHandle(), ev, n, NULL, 0, &now);
-#endif
+        mEventLoop->recheckChannel(mSocket->getFD(), this, mWriteInterest, !mReadPaused);
+    }
+    // 只在发送受阻(EAGAIN或部分写入)后关注可写事件, 发送队列清空后取消,
+    // 避免以读为主的连接每次可读事件都附带一次无效的canSend
+    void setWriteInterest(bool enable)
+    {
+        if (mWriteInterest == enable || mAlreadyClose)
+        {
+            return;
+        }
+        mWriteInterest = enable;
+        recheckEvent();
     }
     void unregisterPollerEvent()
     {
-#ifdef BRYNET_PLATFORM_LINUX
-        struct epoll_event ev = {0,
-                                 {
-                                     nullptr
-                                 }};
-        epoll_ctl(mEventLoop->getEpollHandle(), EPOLL_CTL_DEL, mSocket->getFD(), &ev);
-#elif defined BRYNET_PLATFORM_DARWIN
-        struct kevent ev[2];
-        memset(&ev, 0, sizeof(ev));
-        int n = 0;
-        EV_SET(&ev[n++], mSocket->getFD(), EVFILT_READ, EV_DELETE, 0, 0, NULL);
-        EV_SET(&ev[n++], mSocket->getFD(), EVFILT_WRITE, EV_DELETE, 0, 0, NULL);
-
-        struct timespec now = {0, 0};
-        kevent(mEventLoop->getKqueueHandle(), ev, n, NULL, 0, &now);
-#endif
+        mEventLoop->unlinkChannel(mSocket->getFD());
     }
 #endif
 #ifdef BRYNET_USE_OPENSSL
@@ -1100,7 +1992,7 @@ private:
         bool mustClose = false;
         int ret = 0;
 
-        if (mSSLCtx != nullptr)
+        if (!SSL_is_server(mSSL))
         {
             ret = SSL_connect(mSSL);
         }
@@ -1112,6 +2004,10 @@ private:
         if (ret == 1)
         {
             mIsHandsharked = true;
+            mSSLHelper->onHandshakeCompleted(mSSL);
+#if defined BRYNET_PLATFORM_LINUX && defined BIO_get_ktls_send
+            mKtlsSend = BIO_get_ktls_send(SSL_get_wbio(mSSL)) != 0;
+#endif
             if (checkRead())
             {
                 causeEnterCallback();
@@ -1130,7 +2026,7 @@ private:
             int err = SSL_get_error(mSSL, ret);
             if (err == SSL_ERROR_WANT_WRITE || err == SSL_ERROR_WANT_READ)
             {
-                if (!checkRead())
+                if (!checkRead() || (err == SSL_ERROR_WANT_WRITE && !checkWrite()))
                 {
                     mustClose = true;
                 }
@@ -1163,6 +2059,10 @@ private:
 
     void processRecvMessage()
     {
+        if (mReadPaused)
+        {
+            return;
+        }
         if (mDataCallback != nullptr && buffer_getreadvalidcount(mRecvBuffer.get()) > 0)
         {
             auto reader = brynet::base::BasePacketReader(buffer_getreadptr(mRecvBuffer.get()),
@@ -1192,12 +2092,17 @@ private:
     bool mPostRecvCheck;
     bool mPostWriteCheck;
     bool mPostClose;
+#else
+    bool mWriteInterest;
 #endif
-    const std::string mIP;
+    const struct sockaddr_in6 mRemoteAddr;
+    mutable std::string mIP;
+    mutable std::once_flag mIPOnce;
     const TcpSocket::Ptr mSocket;
     const EventLoop::Ptr mEventLoop;
     bool mCanWrite;
     bool mAlreadyClose;
+    bool mReadPaused;
 
     class BufferDeleter
     {
@@ -1212,31 +2117,74 @@ private:
     size_t mRecvBuffOriginSize = 0;
     const size_t mMaxRecvBufferSize;
 
-    struct PendingPacket
-    {
-        SendableMsg::Ptr data;
-        size_t left;
-        PacketSendedCallback mCompleteCallback;
-    };
-
     std::vector<PacketSendedCallback> pedingCallbacks;
 
-    using PacketListType = std::deque<PendingPacket>;
+    using PacketListType = detail::RingQueue<PendingPacket>;
     PacketListType mSendList;
-    size_t mSendingMsgSize;
+    std::atomic<size_t> mSendingMsgSize;
+    std::atomic<InboundQueue*> mInboundTasks;
+    std::atomic_bool mInboundScheduled;
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+    // quickFlush的iovec窗口, [mSendWindowHead, mSendWindow.size())为尚未写出的部分, 共mSendWindowBytes字节.
+    // mSendWindowSeq/mSendWindowOffset为下一个要加入窗口的消息序号及其消息内偏移
+    std::vector<struct iovec> mSendWindow;
+    size_t mSendWindowHead;
+    size_t mSendWindowBytes;
+    size_t mSendWindowSeq;
+    size_t mSendWindowOffset;
+    bool mSendWindowZeroCopy;
+#endif
+    size_t mCoalesceThreshold;
+    std::string mCoalesceSpareBuffer;
+
+#ifdef BRYNET_PLATFORM_LINUX
+    // 已发送完毕, 等待零拷贝完成通知的消息. seq为释放前需要完成的零拷贝发送序号
+    struct ZeroCopyPacket
+    {
+        PendingPacket packet;
+        uint32_t seq;
+    };
+    std::deque<ZeroCopyPacket> mZeroCopyWaitList;
+    std::vector<std::pair<uint32_t, uint32_t>> mZeroCopyDoneRanges;
+    bool mZeroCopyEnabled;
+    size_t mZeroCopyThreshold;
+    // 下一次零拷贝发送的序号(与内核计数一致), 以及该序号之前已全部完成的位置
+    uint32_t mZeroCopyNextSeq;
+    uint32_t mZeroCopyDoneSeq;
+#endif
 
     EnterCallback mEnterCallback;
     DataCallback mDataCallback;
     DisconnectedCallback mDisConnectCallback;
     HighWaterCallback mHighWaterCallback;
     size_t mHighWaterSize;
+    LowWaterCallback mLowWaterCallback;
+    size_t mLowWaterSize;
+    // 已触发高水位回调, 尚未降到低水位
+    bool mAboveHighWater;
 
     bool mIsPostFlush;
 
+    brynet::base::TokenBucket mSendRateLimiter;
+    brynet::base::TokenBucket::Ptr mSharedSendRateLimiter;
+    // 令牌不足, 等待定时器恢复发送
+    bool mSendPaced;
+    // 暂缓发送期间请求了shutdown
+    bool mShutdownAfterPaced;
+
 #ifdef BRYNET_USE_OPENSSL
+    SSLHelper::Ptr mSSLHelper;
+    // 客户端会话在SSLHelper中的键(主机:端口), 作为SSL的app data
+    std::string mSSLSessionKey;
     SSL_CTX* mSSLCtx;
     SSL* mSSL;
     bool mIsHandsharked;
+    // 握手完成后已启用kTLS发送
+    bool mKtlsSend;
+    // 返回WANT_WRITE的SSL_write的数据, 必须原样重试
+    const char* mSSLPendingWritePtr;
+    size_t mSSLPendingWriteLen;
+    std::string mSSLPendingWriteBuffer;
 #endif
     bool mRecvData;
     std::chrono::nanoseconds mCheckTime{};
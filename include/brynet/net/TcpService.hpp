@@ -5,6 +5,7 @@
 namespace brynet { namespace net {
 
 using ConnectionOption = detail::ConnectionOption;
+using LoopBalance = detail::LoopBalance;
 class TcpService : public detail::TcpServiceDetail,
                    public std::enable_shared_from_this<TcpService>
 {
@@ -22,9 +23,10 @@ public:
     }
 
     void startWorkerThread(size_t threadNum,
-                           FrameCallback callback = nullptr)
+                           FrameCallback callback = nullptr,
+                           EventLoopOption loopOption = EventLoopOption())
     {
-        detail::TcpServiceDetail::startWorkerThread(threadNum, callback);
+        detail::TcpServiceDetail::startWorkerThread(threadNum, callback, loopOption);
     }
 
     void stopWorkerThread()
@@ -42,6 +44,31 @@ public:
         return detail::TcpServiceDetail::getRandomEventLoop();
     }
 
+    std::vector<EventLoop::Ptr> getEventLoops() const
+    {
+        return detail::TcpServiceDetail::getEventLoops();
+    }
+
+    EventLoop::Ptr selectEventLoop(LoopBalance balance)
+    {
+        return detail::TcpServiceDetail::selectEventLoop(balance);
+    }
+
+    std::vector<EventLoopStats> getEventLoopStats() const
+    {
+        return detail::TcpServiceDetail::getEventLoopStats();
+    }
+
+    std::vector<int> getEventLoopNumaNodes() const
+    {
+        return detail::TcpServiceDetail::getEventLoopNumaNodes();
+    }
+
+    void setSendRateLimit(size_t bytesPerSecond, size_t burst = 0)
+    {
+        detail::TcpServiceDetail::setSendRateLimit(bytesPerSecond, burst);
+    }
+
 private:
     TcpService() = default;
 };
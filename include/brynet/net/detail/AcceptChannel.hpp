@@ -0,0 +1,114 @@
+#pragma once
+
+#include <brynet/base/NonCopyable.hpp>
+#include <brynet/net/Channel.hpp>
+#include <brynet/net/EventLoop.hpp>
+#include <brynet/net/Socket.hpp>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <utility>
+
+namespace brynet { namespace net { namespace detail {
+
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+// 注册在EventLoop中的非阻塞监听socket, 在loop线程内accept新连接.
+// 新socket由accept4直接设置为非阻塞, 并保存accept返回的对端地址.
+// 必须由shared_ptr管理(资源不足时通过定时器重试)
+class AcceptChannel final : public Channel,
+                            public brynet::base::NonCopyable,
+                            public std::enable_shared_from_this<AcceptChannel>
+{
+public:
+    using AccepCallback = std::function<void(TcpSocket::Ptr)>;
+
+    // (Linux)每次可读事件最多accept的连接数, 避免连接风暴时长时间占用loop线程
+    static const size_t sMaxAcceptBatch = 64;
+
+    AcceptChannel(EventLoop::Ptr eventLoop, ListenSocket::Ptr listenSocket, AccepCallback callback)
+        : mEventLoop(std::move(eventLoop)),
+          mListenSocket(std::move(listenSocket)),
+          mCallback(std::move(callback))
+    {
+    }
+
+    BrynetSocketFD getFD() const
+    {
+        return mListenSocket->getFD();
+    }
+
+private:
+    void canRecv(bool) override
+    {
+        for (size_t i = 0;; i++)
+        {
+#ifdef BRYNET_PLATFORM_LINUX
+            if (i == sMaxAcceptBatch)
+            {
+                // 边缘触发, backlog中可能还有连接, 重新检测以便下一轮loop继续accept
+                mEventLoop->recheckChannel(getFD(), this, false);
+                return;
+            }
+#endif
+            int errorCode = 0;
+            auto clientSocket = mListenSocket->tryAccept(errorCode);
+            if (clientSocket != nullptr)
+            {
+                mCallback(std::move(clientSocket));
+                continue;
+            }
+
+            if (errorCode == EINTR || errorCode == ECONNABORTED)
+            {
+                continue;
+            }
+            if (errorCode != EAGAIN && errorCode != EWOULDBLOCK)
+            {
+                std::cerr << "accept execption:" << errorCode << std::endl;
+            }
+            if (errorCode == EMFILE || errorCode == ENFILE || errorCode == ENOBUFS || errorCode == ENOMEM)
+            {
+                // 资源耗尽时立即重试只会空转, 稍后再重新检测
+                retryLater();
+            }
+            return;
+        }
+    }
+
+    // 文件描述符或内存不足导致accept失败时, 100毫秒后重新检测
+    void retryLater()
+    {
+        if (mRetryPending)
+        {
+            return;
+        }
+        mRetryPending = true;
+
+        std::weak_ptr<AcceptChannel> weakChannel = shared_from_this();
+        mEventLoop->runAfter(std::chrono::milliseconds(100), [weakChannel]() {
+            if (auto channel = weakChannel.lock())
+            {
+                channel->mRetryPending = false;
+                channel->mEventLoop->recheckChannel(channel->getFD(), channel.get(), false);
+            }
+        });
+    }
+
+    void canSend() override
+    {
+    }
+
+    void onClose() override
+    {
+    }
+
+private:
+    const EventLoop::Ptr mEventLoop;
+    const ListenSocket::Ptr mListenSocket;
+    const AccepCallback mCallback;
+    bool mRetryPending = false;
+};
+#endif
+
+}}}// namespace brynet::net::detail
@@ -5,13 +5,33 @@
 
 namespace brynet { namespace net { namespace detail {
 
+// 新连接选择EventLoop的策略
+enum class LoopBalance
+{
+    // 随机选择
+    Random,
+    // 依次轮流选择
+    RoundRobin,
+    // 选择连接数最少的EventLoop
+    LeastConnections,
+    // 选择待发送字节数最少的EventLoop
+    LeastPendingBytes,
+    // 随机取两个EventLoop, 选择最近负载(getRecentUtilization)较低的一个
+    PowerOfTwoChoices,
+};
+
 class ConnectionOption final
 {
 public:
     std::vector<TcpConnection::EnterCallback> enterCallback;
+    // 工作线程绑定了CPU时连接在工作线程内创建, 创建失败(例如SSL初始化失败)时在该线程调用
+    std::function<void()> failedCallback;
     SSLHelper::Ptr sslHelper;
+    // (客户端)SNI及证书校验使用的主机名
+    std::string sslServerName;
     bool useSSL = false;
     bool forceSameThreadLoop = false;
+    LoopBalance loopBalance = LoopBalance::Random;
     size_t maxRecvBufferSize = 128;
 };
 
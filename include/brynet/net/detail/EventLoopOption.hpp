@@ -0,0 +1,27 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+namespace brynet { namespace net { namespace detail {
+
+class EventLoopOption final
+{
+public:
+    // 仅在Linux并定义了BRYNET_USE_IO_URING时有效,内核不支持时自动回退到epoll
+    bool useIoUring = false;
+    // 使用分层时间轮(精度1毫秒)管理定时器, 适合大量短期且经常被取消的定时器
+    bool useTimingWheel = false;
+    // 大于0时开启忙轮询(仅Linux): 阻塞等待前先以零超时轮询最多busyPollTime,
+    // 期间其他线程投递异步函数无需写eventfd唤醒. 轮询落空时预算自动减半, 命中时恢复
+    std::chrono::microseconds busyPollTime = std::chrono::microseconds::zero();
+    // 仅用于TcpService::startWorkerThread: 第i个工作线程绑定到cpuSets[i % cpuSets.size()]中的CPU,
+    // 并在工作线程内创建EventLoop与TcpConnection, 使其内存分配在本地NUMA节点.
+    // 可使用brynet::base::MakeSpreadCpuSets生成
+    std::vector<std::vector<int>> cpuSets;
+    // 仅用于TcpService::startWorkerThread(Linux): 工作线程分布在多个NUMA节点时,
+    // 新连接只在调用线程(例如accept线程)当前所在节点的工作线程中按loopBalance选择
+    bool preferLocalNumaLoop = false;
+};
+
+}}}// namespace brynet::net::detail
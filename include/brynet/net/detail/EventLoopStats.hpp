@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <brynet/base/Histogram.hpp>
+#include <brynet/base/NonCopyable.hpp>
+#include <chrono>
+#include <cstdint>
+
+namespace brynet { namespace net { namespace detail {
+
+// EventLoop运行数据的快照, 时间单位均为纳秒
+class EventLoopStats final
+{
+public:
+    uint64_t loopCount = 0;
+    // 阻塞等待(含忙轮询)的总时间
+    uint64_t waitTime = 0;
+    // 处理事件/异步函数/定时器等工作的总时间
+    uint64_t busyTime = 0;
+    uint64_t timerTime = 0;
+    uint64_t afterLoopTime = 0;
+    uint64_t eventCount = 0;
+    uint64_t asyncFunctorCount = 0;
+    // TcpConnection收到的可写事件数, 其中发送队列为空(无事可做)的次数
+    uint64_t sendEventCount = 0;
+    uint64_t spuriousSendEventCount = 0;
+    // 修改fd关注事件(EPOLL_CTL_MOD等)的次数
+    uint64_t channelUpdateCount = 0;
+
+    // 每次loop唤醒后的处理耗时
+    brynet::base::Histogram::Snapshot iterationLatency;
+    // 每次唤醒获得的IO事件数量
+    brynet::base::Histogram::Snapshot eventsPerWakeup;
+    // 每次loop处理的异步函数数量, 即处理时异步函数队列的深度
+    brynet::base::Histogram::Snapshot asyncFunctorDepth;
+
+    // 处理工作的时间占比, 接近1表示IO线程已经饱和
+    double utilization() const
+    {
+        const auto total = waitTime + busyTime;
+        return total == 0 ? 0 : static_cast<double>(busyTime) / static_cast<double>(total);
+    }
+};
+
+// 由loop线程记录, 任意线程都可以调用snapshot
+class EventLoopStatsRecorder final : public brynet::base::NonCopyable
+{
+public:
+    void recordIteration(std::chrono::steady_clock::time_point loopStart,
+                         std::chrono::steady_clock::time_point wakeupTime,
+                         std::chrono::steady_clock::time_point afterLoopStart,
+                         std::chrono::steady_clock::time_point timerStart,
+                         std::chrono::steady_clock::time_point loopEnd,
+                         uint64_t eventCount,
+                         uint64_t asyncFunctorCount)
+    {
+        const auto busyTime = toNanoseconds(loopEnd - wakeupTime);
+
+        increase(mLoopCount, 1);
+        increase(mWaitTime, toNanoseconds(wakeupTime - loopStart));
+        increase(mBusyTime, busyTime);
+        increase(mTimerTime, toNanoseconds(loopEnd - timerStart));
+        increase(mAfterLoopTime, toNanoseconds(timerStart - afterLoopStart));
+        increase(mEventCount, eventCount);
+        increase(mAsyncFunctorCount, asyncFunctorCount);
+
+        mIterationLatency.record(busyTime);
+        mEventsPerWakeup.record(eventCount);
+        mAsyncFunctorDepth.record(asyncFunctorCount);
+
+        updateRecentWindow(loopStart, loopEnd, busyTime);
+    }
+
+    // 最近一个统计窗口内处理工作的时间占比, 任意线程都可以调用.
+    // loop长时间阻塞(没有完成新的窗口)时按经过的时间衰减, 避免空闲的loop一直保持旧的高负载
+    double recentUtilization() const
+    {
+        const auto windowStart = mRecentWindowStart.load(std::memory_order_relaxed);
+        const auto windowEnd = mRecentWindowEnd.load(std::memory_order_relaxed);
+        const auto busy = mRecentBusyTime.load(std::memory_order_relaxed);
+        if (windowEnd <= windowStart)
+        {
+            return 0;
+        }
+
+        auto elapsed = windowEnd - windowStart;
+        const auto now = toNanoseconds(std::chrono::steady_clock::now().time_since_epoch());
+        if (now > windowEnd + elapsed)
+        {
+            elapsed = now - windowStart;
+        }
+        return std::min(1.0, static_cast<double>(busy) / static_cast<double>(elapsed));
+    }
+
+    void recordSendEvent(bool spurious)
+    {
+        increase(mSendEventCount, 1);
+        if (spurious)
+        {
+            increase(mSpuriousSendEventCount, 1);
+        }
+    }
+
+    void recordChannelUpdate()
+    {
+        increase(mChannelUpdateCount, 1);
+    }
+
+    EventLoopStats snapshot() const
+    {
+        EventLoopStats stats;
+        stats.loopCount = mLoopCount.load(std::memory_order_relaxed);
+        stats.waitTime = mWaitTime.load(std::memory_order_relaxed);
+        stats.busyTime = mBusyTime.load(std::memory_order_relaxed);
+        stats.timerTime = mTimerTime.load(std::memory_order_relaxed);
+        stats.afterLoopTime = mAfterLoopTime.load(std::memory_order_relaxed);
+        stats.eventCount = mEventCount.load(std::memory_order_relaxed);
+        stats.asyncFunctorCount = mAsyncFunctorCount.load(std::memory_order_relaxed);
+        stats.sendEventCount = mSendEventCount.load(std::memory_order_relaxed);
+        stats.spuriousSendEventCount = mSpuriousSendEventCount.load(std::memory_order_relaxed);
+        stats.channelUpdateCount = mChannelUpdateCount.load(std::memory_order_relaxed);
+        stats.iterationLatency = mIterationLatency.snapshot();
+        stats.eventsPerWakeup = mEventsPerWakeup.snapshot();
+        stats.asyncFunctorDepth = mAsyncFunctorDepth.snapshot();
+        return stats;
+    }
+
+private:
+    static uint64_t toNanoseconds(std::chrono::steady_clock::duration duration)
+    {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        return ns < 0 ? 0 : static_cast<uint64_t>(ns);
+    }
+
+    void updateRecentWindow(std::chrono::steady_clock::time_point loopStart,
+                            std::chrono::steady_clock::time_point loopEnd,
+                            uint64_t busyTime)
+    {
+        if (mWindowStart == std::chrono::steady_clock::time_point())
+        {
+            mWindowStart = loopStart;
+        }
+        mWindowBusyTime += busyTime;
+
+        // 计算recentUtilization的窗口长度
+        const auto recentWindow = std::chrono::milliseconds(10);
+        if (loopEnd - mWindowStart < recentWindow)
+        {
+            return;
+        }
+
+        mRecentWindowStart.store(toNanoseconds(mWindowStart.time_since_epoch()), std::memory_order_relaxed);
+        mRecentWindowEnd.store(toNanoseconds(loopEnd.time_since_epoch()), std::memory_order_relaxed);
+        mRecentBusyTime.store(mWindowBusyTime, std::memory_order_relaxed);
+        mWindowStart = loopEnd;
+        mWindowBusyTime = 0;
+    }
+
+    static void increase(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> mLoopCount{0};
+    std::atomic<uint64_t> mWaitTime{0};
+    std::atomic<uint64_t> mBusyTime{0};
+    std::atomic<uint64_t> mTimerTime{0};
+    std::atomic<uint64_t> mAfterLoopTime{0};
+    std::atomic<uint64_t> mEventCount{0};
+    std::atomic<uint64_t> mAsyncFunctorCount{0};
+    std::atomic<uint64_t> mSendEventCount{0};
+    std::atomic<uint64_t> mSpuriousSendEventCount{0};
+    std::atomic<uint64_t> mChannelUpdateCount{0};
+
+    brynet::base::Histogram mIterationLatency;
+    brynet::base::Histogram mEventsPerWakeup;
+    brynet::base::Histogram mAsyncFunctorDepth;
+
+    // 当前窗口, 仅由loop线程访问
+    std::chrono::steady_clock::time_point mWindowStart;
+    uint64_t mWindowBusyTime = 0;
+
+    std::atomic<uint64_t> mRecentWindowStart{0};
+    std::atomic<uint64_t> mRecentWindowEnd{0};
+    std::atomic<uint64_t> mRecentBusyTime{0};
+};
+
+}}}// namespace brynet::net::detail
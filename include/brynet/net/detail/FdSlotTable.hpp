@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <brynet/base/NonCopyable.hpp>
+#include <brynet/net/SocketLibTypes.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace brynet { namespace net { namespace detail {
+
+// 以fd为下标的稠密槽位表, 查找/插入/删除均为O(1)且不产生节点分配.
+// 每个槽位带有generation计数(奇数表示占用), insert返回的Handle在fd被删除或复用后自动失效
+template<typename T>
+class FdSlotTable final : public brynet::base::NonCopyable
+{
+public:
+    using Handle = uint64_t;
+
+    static const Handle sInvalidHandle = 0;
+
+    // fd为负数时返回sInvalidHandle
+    Handle insert(BrynetSocketFD fd, T value)
+    {
+        if (fd < 0)
+        {
+            return sInvalidHandle;
+        }
+
+        const auto index = static_cast<size_t>(fd);
+        if (index >= mSlots.size())
+        {
+            mSlots.resize(std::max(index + 1, mSlots.size() * 2));
+        }
+
+        auto& slot = mSlots[index];
+        if (!isUsed(slot))
+        {
+            slot.generation++;
+            mSize++;
+        }
+        slot.value = std::move(value);
+
+        return makeHandle(fd, slot.generation);
+    }
+
+    T* findByFd(BrynetSocketFD fd)
+    {
+        const auto index = static_cast<size_t>(fd);
+        if (index >= mSlots.size() || !isUsed(mSlots[index]))
+        {
+            return nullptr;
+        }
+        return &mSlots[index].value;
+    }
+
+    // 只有当handle对应的那一次insert仍然有效时才返回值
+    T* findByHandle(Handle handle)
+    {
+        const auto index = static_cast<size_t>(handle & 0xFFFFFFFF);
+        const auto generation = static_cast<uint32_t>(handle >> 32);
+        if (index >= mSlots.size() || mSlots[index].generation != generation || !isUsed(mSlots[index]))
+        {
+            return nullptr;
+        }
+        return &mSlots[index].value;
+    }
+
+    bool erase(BrynetSocketFD fd)
+    {
+        const auto index = static_cast<size_t>(fd);
+        if (index >= mSlots.size() || !isUsed(mSlots[index]))
+        {
+            return false;
+        }
+
+        auto& slot = mSlots[index];
+        slot.generation++;
+        slot.value = T();
+        mSize--;
+        return true;
+    }
+
+    size_t size() const
+    {
+        return mSize;
+    }
+
+private:
+    struct Slot
+    {
+        T value = T();
+        uint32_t generation = 0;
+    };
+
+    static bool isUsed(const Slot& slot)
+    {
+        return (slot.generation & 1) != 0;
+    }
+
+    static Handle makeHandle(BrynetSocketFD fd, uint32_t generation)
+    {
+        return (static_cast<Handle>(generation) << 32) | static_cast<uint32_t>(fd);
+    }
+
+private:
+    std::vector<Slot> mSlots;
+    size_t mSize = 0;
+};
+
+}}}// namespace brynet::net::detail
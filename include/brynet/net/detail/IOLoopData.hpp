@@ -16,19 +16,22 @@ public:
     using Ptr = std::shared_ptr<IOLoopData>;
 
     static Ptr Create(EventLoop::Ptr eventLoop,
-                      std::shared_ptr<std::thread> ioThread)
+                      std::shared_ptr<std::thread> ioThread,
+                      int numaNode = -1)
     {
         class make_shared_enabler : public IOLoopData
         {
         public:
             make_shared_enabler(EventLoop::Ptr eventLoop,
-                                std::shared_ptr<std::thread> ioThread)
-                : IOLoopData(std::move(eventLoop), std::move(ioThread))
+                                std::shared_ptr<std::thread> ioThread,
+                                int numaNode)
+                : IOLoopData(std::move(eventLoop), std::move(ioThread), numaNode)
             {}
         };
 
         return std::make_shared<make_shared_enabler>(std::move(eventLoop),
-                                                     std::move(ioThread));
+                                                     std::move(ioThread),
+                                                     numaNode);
     }
 
     const EventLoop::Ptr& getEventLoop() const
@@ -36,6 +39,12 @@ public:
         return mEventLoop;
     }
 
+    // 工作线程绑定的CPU所在的NUMA节点, 未绑定时为-1
+    int getNumaNode() const
+    {
+        return mNumaNode;
+    }
+
 protected:
     const std::shared_ptr<std::thread>& getIOThread() const
     {
@@ -43,9 +52,11 @@ protected:
     }
 
     IOLoopData(EventLoop::Ptr eventLoop,
-               std::shared_ptr<std::thread> ioThread)
+               std::shared_ptr<std::thread> ioThread,
+               int numaNode)
         : mEventLoop(std::move(eventLoop)),
-          mIOThread(std::move(ioThread))
+          mIOThread(std::move(ioThread)),
+          mNumaNode(numaNode)
     {}
     virtual ~IOLoopData() = default;
 
@@ -53,6 +64,7 @@ protected:
 
 private:
     std::shared_ptr<std::thread> mIOThread;
+    const int mNumaNode;
 
     friend class TcpServiceDetail;
 };
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <brynet/base/Noexcept.hpp>
+#include <brynet/base/NonCopyable.hpp>
+#include <brynet/net/Exception.hpp>
+#include <brynet/net/Socket.hpp>
+#include <brynet/net/SocketLibFunction.hpp>
+#include <brynet/net/TcpService.hpp>
+#include <brynet/net/detail/AcceptChannel.hpp>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace brynet { namespace net { namespace detail {
+
+// 每个工作线程的EventLoop各自打开一个SO_REUSEPORT监听socket, 由内核分配新连接,
+// 在loop线程内非阻塞accept, 新连接无需跨线程投递
+class LoopListenerDetail : public brynet::base::NonCopyable
+{
+protected:
+    // 在accept该连接的loop线程中调用
+    using AccepCallback = std::function<void(TcpSocket::Ptr)>;
+    using TcpSocketProcessCallback = std::function<void(TcpSocket&)>;
+
+    void startListen()
+    {
+        std::lock_guard<std::mutex> lck(mListenGuard);
+
+        if (!mListenDatas.empty())
+        {
+            return;
+        }
+
+#ifdef BRYNET_PLATFORM_WINDOWS
+        throw BrynetCommonException("loop listener is not supported on windows");
+#else
+        const auto eventLoops = mService->getEventLoops();
+        if (eventLoops.empty())
+        {
+            throw BrynetCommonException("tcp service not start worker thread");
+        }
+
+        auto callback = mCallback;
+        auto processCallbacks = mProcessCallbacks;
+        auto acceptCallback = [callback, processCallbacks](TcpSocket::Ptr clientSocket) {
+            for (const auto& process : processCallbacks)
+            {
+                process(*clientSocket);
+            }
+            callback(std::move(clientSocket));
+        };
+
+        // 先完成所有socket的bind, 任意一个失败时不会有loop开始accept
+        std::vector<ListenData> listenDatas;
+        for (const auto& eventLoop : eventLoops)
+        {
+            const auto fd = brynet::net::base::Listen(mIsIPV6, mIP.c_str(), mPort, 512, true);
+            if (fd == BRYNET_INVALID_SOCKET)
+            {
+                throw BrynetCommonException(
+                        std::string("listen error of:") + std::to_string(BRYNET_ERRNO));
+            }
+            auto listenSocket = ListenSocket::Create(fd);
+            brynet::net::base::SocketNonblock(fd);
+
+            ListenData data;
+            data.eventLoop = eventLoop;
+            data.channel = std::make_shared<AcceptChannel>(eventLoop, std::move(listenSocket), acceptCallback);
+            listenDatas.push_back(std::move(data));
+        }
+
+        for (size_t i = 0; i < listenDatas.size(); i++)
+        {
+            const auto eventLoop = listenDatas[i].eventLoop;
+            const auto channel = listenDatas[i].channel;
+            const auto linked = runInLoopAndWait(eventLoop, [eventLoop, channel]() {
+                return eventLoop->linkChannel(channel->getFD(), channel.get(), false);
+            });
+            if (!linked)
+            {
+                listenDatas.resize(i);
+                unlinkChannels(listenDatas);
+                throw BrynetCommonException("link accept channel failed");
+            }
+        }
+
+        mListenDatas = std::move(listenDatas);
+#endif
+    }
+
+    void stopListen()
+    {
+        std::lock_guard<std::mutex> lck(mListenGuard);
+
+        unlinkChannels(mListenDatas);
+        mListenDatas.clear();
+    }
+
+protected:
+    LoopListenerDetail(TcpService::Ptr service,
+                       bool isIPV6,
+                       const std::string& ip,
+                       int port,
+                       const AccepCallback& callback,
+                       const std::vector<TcpSocketProcessCallback>& processCallbacks)
+        : mService(std::move(service)),
+          mIsIPV6(isIPV6),
+          mIP(ip),
+          mPort(port),
+          mCallback(callback),
+          mProcessCallbacks(processCallbacks)
+    {
+        if (mService == nullptr)
+        {
+            throw BrynetCommonException("tcp service is nullptr");
+        }
+        if (mCallback == nullptr)
+        {
+            throw BrynetCommonException("accept callback is nullptr");
+        }
+    }
+
+    virtual ~LoopListenerDetail() BRYNET_NOEXCEPT
+    {
+        stopListen();
+    }
+
+private:
+#ifdef BRYNET_PLATFORM_WINDOWS
+    class AcceptChannel;
+#endif
+
+    struct ListenData
+    {
+        EventLoop::Ptr eventLoop;
+        std::shared_ptr<AcceptChannel> channel;
+    };
+
+    void unlinkChannels(const std::vector<ListenData>& listenDatas)
+    {
+#ifndef BRYNET_PLATFORM_WINDOWS
+        for (const auto& data : listenDatas)
+        {
+            const auto eventLoop = data.eventLoop;
+            const auto channel = data.channel;
+            runInLoopAndWait(eventLoop, [eventLoop, channel]() {
+                eventLoop->unlinkChannel(channel->getFD());
+                return true;
+            });
+        }
+#else
+        (void) listenDatas;
+#endif
+    }
+
+    // 在eventLoop线程中执行f并等待其完成.
+    // 工作线程已经停止时放弃等待并返回false, 此时f由EventLoop析构时连同channel一起释放
+    template<typename F>
+    bool runInLoopAndWait(const EventLoop::Ptr& eventLoop, F f)
+    {
+        if (eventLoop->isInLoopThread())
+        {
+            return f();
+        }
+
+        auto promise = std::make_shared<std::promise<bool>>();
+        auto future = promise->get_future();
+        eventLoop->runAsyncFunctor([promise, f]() {
+            promise->set_value(f());
+        });
+
+        while (future.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready)
+        {
+            if (mService->getEventLoops().empty())
+            {
+                return false;
+            }
+        }
+        return future.get();
+    }
+
+private:
+    const TcpService::Ptr mService;
+    const bool mIsIPV6;
+    const std::string mIP;
+    const int mPort;
+    const AccepCallback mCallback;
+    const std::vector<TcpSocketProcessCallback> mProcessCallbacks;
+
+    std::vector<ListenData> mListenDatas;
+    std::mutex mListenGuard;
+};
+
+}}}// namespace brynet::net::detail
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <brynet/base/NonCopyable.hpp>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace brynet { namespace net { namespace detail {
+
+// 容量为2的幂的环形队列, 入队/出队不产生节点分配, 队满时容量翻倍.
+// 每个元素有一个入队序号(从0开始单调递增, 不随出队改变), 可以通过序号直接访问仍在队列中的元素
+template<typename T>
+class RingQueue final : public brynet::base::NonCopyable
+{
+public:
+    bool empty() const
+    {
+        return mHead == mTail;
+    }
+
+    size_t size() const
+    {
+        return mTail - mHead;
+    }
+
+    // 队首元素的序号
+    size_t headSeq() const
+    {
+        return mHead;
+    }
+
+    // 下一个入队元素的序号
+    size_t tailSeq() const
+    {
+        return mTail;
+    }
+
+    T& atSeq(size_t seq)
+    {
+        assert(seq - mHead < size());
+        return mSlots[seq & mMask];
+    }
+
+    T& operator[](size_t i)
+    {
+        return atSeq(mHead + i);
+    }
+
+    T& front()
+    {
+        return atSeq(mHead);
+    }
+
+    T& back()
+    {
+        return atSeq(mTail - 1);
+    }
+
+    void push_back(T&& value)
+    {
+        if (size() == mSlots.size())
+        {
+            grow();
+        }
+        mSlots[mTail & mMask] = std::move(value);
+        mTail++;
+    }
+
+    void pop_front()
+    {
+        assert(!empty());
+        // 立即释放元素持有的资源
+        mSlots[mHead & mMask] = T();
+        mHead++;
+    }
+
+    void clear()
+    {
+        while (!empty())
+        {
+            pop_front();
+        }
+    }
+
+private:
+    void grow()
+    {
+        const auto newCapacity = mSlots.empty() ? 16 : mSlots.size() * 2;
+        std::vector<T> newSlots(newCapacity);
+        const auto newMask = newCapacity - 1;
+        for (auto seq = mHead; seq != mTail; seq++)
+        {
+            newSlots[seq & newMask] = std::move(mSlots[seq & mMask]);
+        }
+        mSlots.swap(newSlots);
+        mMask = newMask;
+    }
+
+private:
+    std::vector<T> mSlots;
+    size_t mMask = 0;
+    size_t mHead = 0;
+    size_t mTail = 0;
+};
+
+}}}// namespace brynet::net::detail
@@ -1,15 +1,21 @@
 ﻿#pragma once
 
+#include <brynet/base/CpuAffinity.hpp>
 #include <brynet/base/Noexcept.hpp>
 #include <brynet/base/NonCopyable.hpp>
+#include <brynet/base/TokenBucket.hpp>
 #include <brynet/net/SSLHelper.hpp>
 #include <brynet/net/Socket.hpp>
 #include <brynet/net/TcpConnection.hpp>
 #include <brynet/net/detail/ConnectionOption.hpp>
 #include <brynet/net/detail/IOLoopData.hpp>
+#include <atomic>
 #include <functional>
+#include <future>
+#include <iostream>
 #include <memory>
 #include <random>
+#include <set>
 #include <thread>
 #include <vector>
 
@@ -22,7 +28,8 @@ protected:
     const static unsigned int sDefaultLoopTimeOutMS = 100;
 
     void startWorkerThread(size_t threadNum,
-                           FrameCallback callback = nullptr)
+                           FrameCallback callback = nullptr,
+                           EventLoopOption loopOption = EventLoopOption())
     {
         std::lock_guard<std::mutex> lck(mServiceGuard);
         std::lock_guard<std::mutex> lock(mIOLoopGuard);
@@ -32,26 +39,67 @@ protected:
             return;
         }
 
-        mRunIOLoop = std::make_shared<bool>(true);
+        mRunIOLoop = std::make_shared<std::atomic_bool>(true);
 
         mIOLoopDatas.resize(threadNum);
-        for (auto& v : mIOLoopDatas)
+        mCreateConnectionInLoop = !loopOption.cpuSets.empty();
+        for (size_t i = 0; i < mIOLoopDatas.size(); i++)
         {
-            auto eventLoop = std::make_shared<EventLoop>();
+            std::vector<int> cpus;
+            int numaNode = -1;
+            if (!loopOption.cpuSets.empty())
+            {
+                cpus = loopOption.cpuSets[i % loopOption.cpuSets.size()];
+                if (!cpus.empty())
+                {
+                    numaNode = brynet::base::GetCpuNumaNode(cpus.front());
+                }
+            }
+
             auto runIoLoop = mRunIOLoop;
-            v = IOLoopData::Create(eventLoop,
-                                   std::make_shared<std::thread>(
-                                           [callback, runIoLoop, eventLoop]() {
-                                               while (*runIoLoop)
-                                               {
-                                                   eventLoop->loopCompareNearTimer(sDefaultLoopTimeOutMS);
-                                                   if (callback != nullptr)
-                                                   {
-                                                       callback(eventLoop);
-                                                   }
-                                               }
-                                           }));
+#ifdef BRYNET_PLATFORM_LINUX
+            // 定时器由timerfd唤醒, 没有帧回调时空闲的工作线程无需周期性醒来,
+            // stopWorkerThread依靠wakeup(包括忙轮询期间)让工作线程返回并检查退出标记
+            const int64_t loopTimeout = callback != nullptr ? sDefaultLoopTimeOutMS : -1;
+#else
+            const int64_t loopTimeout = sDefaultLoopTimeOutMS;
+#endif
+            // 先绑定CPU再在工作线程内创建EventLoop, 使其内存由本地NUMA节点分配(first-touch)
+            auto eventLoopPromise = std::make_shared<std::promise<EventLoop::Ptr>>();
+            auto eventLoopFuture = eventLoopPromise->get_future();
+            auto ioThread = std::make_shared<std::thread>(
+                    [callback, runIoLoop, loopOption, loopTimeout, cpus, eventLoopPromise]() {
+                        if (!cpus.empty())
+                        {
+                            brynet::base::SetCurrentThreadAffinity(cpus);
+                        }
+
+                        auto eventLoop = std::make_shared<EventLoop>(loopOption);
+                        eventLoopPromise->set_value(eventLoop);
+
+                        while (*runIoLoop)
+                        {
+                            eventLoop->loopCompareNearTimer(loopTimeout);
+                            if (callback != nullptr)
+                            {
+                                callback(eventLoop);
+                            }
+                        }
+                    });
+            mIOLoopDatas[i] = IOLoopData::Create(eventLoopFuture.get(), ioThread, numaNode);
         }
+
+        std::unique_ptr<EventLoopTable> eventLoops(new EventLoopTable);
+        for (const auto& v : mIOLoopDatas)
+        {
+            eventLoops->loops.push_back(v->getEventLoop());
+        }
+        if (loopOption.preferLocalNumaLoop)
+        {
+            initNumaLoops(*eventLoops);
+        }
+        mEventLoops.store(eventLoops.get(), std::memory_order_release);
+        mEventLoopLists.push_back(std::move(eventLoops));
     }
 
     void stopWorkerThread()
@@ -60,6 +108,7 @@ protected:
         std::lock_guard<std::mutex> lock(mIOLoopGuard);
 
         *mRunIOLoop = false;
+        mEventLoops.store(nullptr, std::memory_order_release);
 
         for (const auto& v : mIOLoopDatas)
         {
@@ -93,14 +142,16 @@ protected:
         }
         else
         {
-            eventLoop = getRandomEventLoop();
+            eventLoop = selectEventLoop(option.loopBalance);
         }
         if (eventLoop == nullptr)
         {
             return false;
         }
 
-        auto wrapperEnterCallback = [option](const TcpConnection::Ptr& tcpConnection) {
+        auto sendRateLimiter = mSendRateLimiter;
+        auto wrapperEnterCallback = [option, sendRateLimiter](const TcpConnection::Ptr& tcpConnection) {
+            tcpConnection->setSharedSendRateLimiter(sendRateLimiter);
             for (const auto& callback : option.enterCallback)
             {
                 callback(tcpConnection);
@@ -112,39 +163,136 @@ protected:
             option.sslHelper = SSLHelper::Create();
         }
 
+        if (mCreateConnectionInLoop && !eventLoop->isInLoopThread())
+        {
+            eventLoop->runAsyncFunctor(CreateConnectionFunctor(std::move(socket),
+                                                               option.maxRecvBufferSize,
+                                                               wrapperEnterCallback,
+                                                               option.failedCallback,
+                                                               eventLoop,
+                                                               option.sslHelper,
+                                                               option.sslServerName));
+            return true;
+        }
+
         TcpConnection::Create(std::move(socket),
                               option.maxRecvBufferSize,
                               wrapperEnterCallback,
                               eventLoop,
-                              option.sslHelper);
+                              option.sslHelper,
+                              option.sslServerName);
 
         return true;
     }
 
-    EventLoop::Ptr getRandomEventLoop()
+    // 本服务所有连接的总发送速率限制(字节/秒), 对已有连接立即生效. bytesPerSecond为0表示不限速
+    void setSendRateLimit(size_t bytesPerSecond, size_t burst)
+    {
+        mSendRateLimiter->setRate(bytesPerSecond, burst);
+    }
+
+    // 每个工作线程所在的NUMA节点(未绑定CPU时为-1), 顺序与getEventLoopStats一致
+    std::vector<int> getEventLoopNumaNodes() const
     {
         std::lock_guard<std::mutex> lock(mIOLoopGuard);
 
-        const auto ioLoopSize = mIOLoopDatas.size();
-        if (ioLoopSize == 0)
+        std::vector<int> result;
+        result.reserve(mIOLoopDatas.size());
+        for (const auto& v : mIOLoopDatas)
+        {
+            result.push_back(v->getNumaNode());
+        }
+        return result;
+    }
+
+    // 当前所有工作线程的EventLoop, 未开启工作线程时为空
+    std::vector<EventLoop::Ptr> getEventLoops() const
+    {
+        const auto eventLoops = mEventLoops.load(std::memory_order_acquire);
+        if (eventLoops == nullptr)
+        {
+            return {};
+        }
+        return eventLoops->loops;
+    }
+
+    EventLoop::Ptr getRandomEventLoop()
+    {
+        return selectEventLoop(LoopBalance::Random);
+    }
+
+    // 按照balance策略选择一个工作线程的EventLoop, 无锁, 可在任意线程调用.
+    // 开启preferLocalNumaLoop时只在调用线程当前所在NUMA节点的工作线程中选择
+    EventLoop::Ptr selectEventLoop(LoopBalance balance)
+    {
+        const auto eventLoops = mEventLoops.load(std::memory_order_acquire);
+        if (eventLoops == nullptr || eventLoops->loops.empty())
         {
             return nullptr;
         }
-        else if (ioLoopSize == 1)
+
+        const auto& loops = LocalEventLoops(*eventLoops);
+        const auto size = loops.size();
+        if (size == 1)
         {
-            return mIOLoopDatas.front()->getEventLoop();
+            return loops.front();
         }
-        else
+
+        switch (balance)
         {
-            return mIOLoopDatas[mRandom() % ioLoopSize]->getEventLoop();
+            case LoopBalance::RoundRobin:
+                return loops[mNextLoopIndex.fetch_add(1, std::memory_order_relaxed) % size];
+            case LoopBalance::LeastConnections:
+                return selectLeastLoaded(loops, [](const EventLoop::Ptr& eventLoop) {
+                    return eventLoop->getConnectionNum();
+                });
+            case LoopBalance::LeastPendingBytes:
+                return selectLeastLoaded(loops, [](const EventLoop::Ptr& eventLoop) {
+                    return eventLoop->getPendingSendBytes();
+                });
+            case LoopBalance::PowerOfTwoChoices:
+            {
+                const auto first = RandomIndex(size);
+                auto second = RandomIndex(size - 1);
+                if (second >= first)
+                {
+                    second++;
+                }
+
+                const auto& a = loops[first];
+                const auto& b = loops[second];
+                const auto utilizationA = a->getRecentUtilization();
+                const auto utilizationB = b->getRecentUtilization();
+                if (utilizationA != utilizationB)
+                {
+                    return utilizationA < utilizationB ? a : b;
+                }
+                return a->getConnectionNum() <= b->getConnectionNum() ? a : b;
+            }
+            case LoopBalance::Random:
+            default:
+                return loops[RandomIndex(size)];
         }
     }
 
+    // 每个工作线程EventLoop的运行数据快照, 可在任意线程调用
+    std::vector<EventLoopStats> getEventLoopStats() const
+    {
+        std::lock_guard<std::mutex> lock(mIOLoopGuard);
+
+        std::vector<EventLoopStats> result;
+        result.reserve(mIOLoopDatas.size());
+        for (const auto& v : mIOLoopDatas)
+        {
+            result.push_back(v->getEventLoop()->getStats());
+        }
+        return result;
+    }
+
     TcpServiceDetail() BRYNET_NOEXCEPT
-        : mRandom(static_cast<unsigned int>(
-                  std::chrono::system_clock::now().time_since_epoch().count()))
+        : mSendRateLimiter(brynet::base::TokenBucket::Create())
     {
-        mRunIOLoop = std::make_shared<bool>(false);
+        mRunIOLoop = std::make_shared<std::atomic_bool>(false);
     }
 
     virtual ~TcpServiceDetail() BRYNET_NOEXCEPT
@@ -154,24 +302,185 @@ protected:
 
     EventLoop::Ptr getSameThreadEventLoop()
     {
-        std::lock_guard<std::mutex> lock(mIOLoopGuard);
-        for (const auto& v : mIOLoopDatas)
+        const auto eventLoops = mEventLoops.load(std::memory_order_acquire);
+        if (eventLoops == nullptr)
         {
-            if (v->getEventLoop()->isInLoopThread())
+            return nullptr;
+        }
+        for (const auto& eventLoop : eventLoops->loops)
+        {
+            if (eventLoop->isInLoopThread())
             {
-                return v->getEventLoop();
+                return eventLoop;
             }
         }
         return nullptr;
     }
 
 private:
+    using EventLoopList = std::vector<EventLoop::Ptr>;
+
+    // 工作线程EventLoop的只读快照
+    struct EventLoopTable
+    {
+        EventLoopList loops;
+        // 下标为NUMA节点, 只在开启preferLocalNumaLoop且工作线程分布在多个节点时不为空
+        std::vector<EventLoopList> numaLoops;
+        // 下标为cpu编号, 值为其NUMA节点
+        std::vector<int> cpuNumaNodes;
+    };
+
+    void initNumaLoops(EventLoopTable& table) const
+    {
+        std::set<int> nodes;
+        for (const auto& v : mIOLoopDatas)
+        {
+            if (v->getNumaNode() >= 0)
+            {
+                nodes.insert(v->getNumaNode());
+            }
+        }
+        if (nodes.size() < 2)
+        {
+            return;
+        }
+
+        for (const auto& info : brynet::base::GetCpuLayout())
+        {
+            if (static_cast<size_t>(info.cpu) >= table.cpuNumaNodes.size())
+            {
+                table.cpuNumaNodes.resize(info.cpu + 1, -1);
+            }
+            table.cpuNumaNodes[info.cpu] = info.numaNode;
+        }
+        table.numaLoops.resize(*nodes.rbegin() + 1);
+        for (const auto& v : mIOLoopDatas)
+        {
+            if (v->getNumaNode() >= 0)
+            {
+                table.numaLoops[v->getNumaNode()].push_back(v->getEventLoop());
+            }
+        }
+    }
+
+    // 调用线程当前CPU所在NUMA节点上的EventLoop, 该节点没有工作线程时返回全部EventLoop
+    static const EventLoopList& LocalEventLoops(const EventLoopTable& table)
+    {
+#ifdef BRYNET_PLATFORM_LINUX
+        if (!table.numaLoops.empty())
+        {
+            const auto cpu = sched_getcpu();
+            if (cpu >= 0 && static_cast<size_t>(cpu) < table.cpuNumaNodes.size())
+            {
+                const auto node = table.cpuNumaNodes[cpu];
+                if (node >= 0 &&
+                    static_cast<size_t>(node) < table.numaLoops.size() &&
+                    !table.numaLoops[node].empty())
+                {
+                    return table.numaLoops[node];
+                }
+            }
+        }
+#endif
+        return table.loops;
+    }
+
+    static size_t RandomIndex(size_t size)
+    {
+        static thread_local std::minstd_rand random(static_cast<unsigned int>(
+                std::chrono::system_clock::now().time_since_epoch().count() ^
+                std::hash<std::thread::id>()(std::this_thread::get_id())));
+        return random() % size;
+    }
+
+    // 从轮转的起点开始扫描, 负载相同时不会总是选中第一个EventLoop
+    template<typename LoadGetter>
+    EventLoop::Ptr selectLeastLoaded(const EventLoopList& loops, LoadGetter getLoad)
+    {
+        const auto size = loops.size();
+        const auto start = mNextLoopIndex.fetch_add(1, std::memory_order_relaxed) % size;
+
+        auto result = start;
+        auto minLoad = getLoad(loops[start]);
+        for (size_t i = 1; i < size && minLoad > 0; i++)
+        {
+            const auto index = (start + i) % size;
+            const auto load = getLoad(loops[index]);
+            if (load < minLoad)
+            {
+                minLoad = load;
+                result = index;
+            }
+        }
+        return loops[result];
+    }
+
+    // 在工作线程内创建TcpConnection, 使连接对象和接收缓冲区由该线程首次访问(NUMA first-touch)
+    class CreateConnectionFunctor
+    {
+    public:
+        CreateConnectionFunctor(TcpSocket::Ptr socket,
+                                size_t maxRecvBufferSize,
+                                TcpConnection::EnterCallback&& enterCallback,
+                                std::function<void()> failedCallback,
+                                EventLoop::Ptr eventLoop,
+                                SSLHelper::Ptr sslHelper,
+                                std::string sslServerName)
+            : mSocket(std::move(socket)),
+              mMaxRecvBufferSize(maxRecvBufferSize),
+              mEnterCallback(std::move(enterCallback)),
+              mFailedCallback(std::move(failedCallback)),
+              mEventLoop(std::move(eventLoop)),
+              mSSLHelper(std::move(sslHelper)),
+              mSSLServerName(std::move(sslServerName))
+        {
+        }
+
+        void operator()()
+        {
+            try
+            {
+                TcpConnection::Create(std::move(mSocket),
+                                      mMaxRecvBufferSize,
+                                      std::move(mEnterCallback),
+                                      mEventLoop,
+                                      mSSLHelper,
+                                      mSSLServerName);
+            }
+            catch (const std::exception& e)
+            {
+                // addTcpConnection已经返回true, 只能通过failedCallback通知调用者, 连接随之关闭
+                std::cerr << "create connection execption:" << e.what() << std::endl;
+                if (mFailedCallback != nullptr)
+                {
+                    mFailedCallback();
+                }
+            }
+        }
+
+    private:
+        TcpSocket::Ptr mSocket;
+        size_t mMaxRecvBufferSize;
+        TcpConnection::EnterCallback mEnterCallback;
+        std::function<void()> mFailedCallback;
+        EventLoop::Ptr mEventLoop;
+        SSLHelper::Ptr mSSLHelper;
+        std::string mSSLServerName;
+    };
+
     std::vector<IOLoopDataPtr> mIOLoopDatas;
     mutable std::mutex mIOLoopGuard;
-    std::shared_ptr<bool> mRunIOLoop;
+    std::shared_ptr<std::atomic_bool> mRunIOLoop;
+    bool mCreateConnectionInLoop = false;
+    const brynet::base::TokenBucket::Ptr mSendRateLimiter;
 
     std::mutex mServiceGuard;
-    std::mt19937 mRandom;
+
+    // 当前工作线程的EventLoop列表, 供selectEventLoop无锁读取.
+    // 发布过的列表保留到析构, 读者持有的指针始终有效
+    std::atomic<const EventLoopTable*> mEventLoops{nullptr};
+    std::vector<std::unique_ptr<const EventLoopTable>> mEventLoopLists;
+    std::atomic<size_t> mNextLoopIndex{0};
 };
 
 }}}// namespace brynet::net::detail
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <brynet/base/NonCopyable.hpp>
+#include <brynet/net/Channel.hpp>
+#include <brynet/net/Socket.hpp>
+#include <chrono>
+#include <cstring>
+
+#ifdef BRYNET_PLATFORM_LINUX
+#include <sys/timerfd.h>
+#endif
+
+namespace brynet { namespace net { namespace detail {
+
+#ifdef BRYNET_PLATFORM_LINUX
+// 使用timerfd在定时器到期时唤醒EventLoop, 精度不受epoll_wait毫秒超时的限制
+class TimerChannel final : public Channel, public brynet::base::NonCopyable
+{
+public:
+    explicit TimerChannel(BrynetSocketFD fd)
+        : mUniqueFd(fd),
+          mArmedTime(std::chrono::steady_clock::time_point::max())
+    {
+    }
+
+    BrynetSocketFD getFD() const
+    {
+        return mUniqueFd.getFD();
+    }
+
+    // 在expireTime时触发可读事件, 与当前已设置的时间相同时不做系统调用.
+    // 返回false表示expireTime已经到达
+    bool arm(std::chrono::steady_clock::time_point expireTime)
+    {
+        if (expireTime == mArmedTime)
+        {
+            return true;
+        }
+
+        const auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                expireTime - std::chrono::steady_clock::now());
+        if (left <= std::chrono::nanoseconds::zero())
+        {
+            return false;
+        }
+
+        struct itimerspec value;
+        memset(&value, 0, sizeof(value));
+        value.it_value.tv_sec = static_cast<time_t>(left.count() / (1000 * 1000 * 1000));
+        value.it_value.tv_nsec = static_cast<long>(left.count() % (1000 * 1000 * 1000));
+        if (timerfd_settime(mUniqueFd.getFD(), 0, &value, nullptr) != 0)
+        {
+            return false;
+        }
+
+        mArmedTime = expireTime;
+        return true;
+    }
+
+private:
+    void canRecv(bool) override
+    {
+        uint64_t expirations = 0;
+        while (read(mUniqueFd.getFD(), &expirations, sizeof(expirations)) > 0)
+        {
+        }
+        mArmedTime = std::chrono::steady_clock::time_point::max();
+    }
+
+    void canSend() override
+    {
+    }
+
+    void onClose() override
+    {
+    }
+
+private:
+    UniqueFd mUniqueFd;
+    std::chrono::steady_clock::time_point mArmedTime;
+};
+#endif
+
+}}}// namespace brynet::net::detail
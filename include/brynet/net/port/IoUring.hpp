@@ -0,0 +1,447 @@
+#pragma once
+
+#include <brynet/base/NonCopyable.hpp>
+#include <brynet/net/SocketLibTypes.hpp>
+
+#if defined BRYNET_PLATFORM_LINUX && defined BRYNET_USE_IO_URING
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#endif
+
+namespace brynet { namespace net { namespace port {
+
+#if defined BRYNET_PLATFORM_LINUX && defined BRYNET_USE_IO_URING
+// 基于io_uring的就绪事件引擎:每个fd注册一个multishot IORING_OP_POLL_ADD,
+// 注册/重新检测/注销请求都先放入SQ,再与等待操作合并为一次io_uring_enter提交.
+// 只替代epoll_ctl/epoll_wait, recv/send/accept仍是普通的系统调用.
+class IoUring final : public brynet::base::NonCopyable
+{
+public:
+    static std::unique_ptr<IoUring> Create(unsigned int entries)
+    {
+        std::unique_ptr<IoUring> ring(new IoUring());
+        if (!ring->init(entries))
+        {
+            return nullptr;
+        }
+        return ring;
+    }
+
+    ~IoUring()
+    {
+        if (mSqes != MAP_FAILED)
+        {
+            munmap(mSqes, mSqesSize);
+        }
+        if (mCqRing != MAP_FAILED && mCqRing != mSqRing)
+        {
+            munmap(mCqRing, mCqRingSize);
+        }
+        if (mSqRing != MAP_FAILED)
+        {
+            munmap(mSqRing, mSqRingSize);
+        }
+        if (mRingFd >= 0)
+        {
+            close(mRingFd);
+        }
+    }
+
+    bool addChannel(BrynetSocketFD fd, void* channel, uint32_t events)
+    {
+        if (fd < 0)
+        {
+            return false;
+        }
+        if (static_cast<size_t>(fd) >= mRegistrations.size())
+        {
+            mRegistrations.resize(static_cast<size_t>(fd) + 1);
+        }
+
+        auto& registration = mRegistrations[fd];
+        if (registration.channel != nullptr)
+        {
+            return false;
+        }
+        registration.channel = channel;
+        registration.events = events;
+        registration.generation++;
+        registration.failures = 0;
+
+        return armPoll(fd, registration.generation, events);
+    }
+
+    // 取消旧的poll并以events重新注册,内核会立即重新检测fd的就绪状态(等价于EPOLL_CTL_MOD)
+    bool rearmChannel(BrynetSocketFD fd, uint32_t events)
+    {
+        if (fd < 0 || static_cast<size_t>(fd) >= mRegistrations.size())
+        {
+            return false;
+        }
+
+        auto& registration = mRegistrations[fd];
+        if (registration.channel == nullptr)
+        {
+            return false;
+        }
+        cancelPoll(fd, registration.generation);
+        registration.events = events;
+        registration.generation++;
+
+        return armPoll(fd, registration.generation, events);
+    }
+
+    void removeChannel(BrynetSocketFD fd)
+    {
+        if (fd < 0 || static_cast<size_t>(fd) >= mRegistrations.size())
+        {
+            return;
+        }
+
+        auto& registration = mRegistrations[fd];
+        if (registration.channel == nullptr)
+        {
+            return;
+        }
+        cancelPoll(fd, registration.generation);
+        registration.channel = nullptr;
+        registration.generation++;
+    }
+
+    // 提交所有排队的SQE并等待完成事件(milliseconds为0时不阻塞)
+    void submitAndWait(int64_t milliseconds)
+    {
+        enter(milliseconds);
+    }
+
+    bool hasCompletions() const
+    {
+        return *mCqHead != __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+    }
+
+    // 内核不支持multishot poll时的错误码(正数), 0表示没有错误, 此时由调用者回退到epoll.
+    // 单个fd的poll失败只影响该fd, 见processCompletions
+    int armError() const
+    {
+        return mArmError;
+    }
+
+    // 对每个已注册的fd调用callback(fd, channel, events), 用于回退到epoll时迁移注册
+    template<typename Callback>
+    void foreachChannel(Callback&& callback) const
+    {
+        for (size_t fd = 0; fd < mRegistrations.size(); fd++)
+        {
+            const auto& registration = mRegistrations[fd];
+            if (registration.channel != nullptr)
+            {
+                callback(static_cast<BrynetSocketFD>(fd), registration.channel, registration.events);
+            }
+        }
+    }
+
+    // 对每个就绪的channel调用callback(channel, events), 返回处理的CQE数量
+    template<typename Callback>
+    int processCompletions(Callback&& callback)
+    {
+        int count = 0;
+        unsigned int head = *mCqHead;
+        const unsigned int tail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head)
+        {
+            const auto& cqe = mCqes[head & mCqMask];
+            const auto userData = cqe.user_data;
+            const auto res = cqe.res;
+            const auto flags = cqe.flags;
+            __atomic_store_n(mCqHead, head + 1, __ATOMIC_RELEASE);
+
+            ++count;
+            if (userData == sCancelUserData)
+            {
+                continue;
+            }
+
+            const auto fd = static_cast<BrynetSocketFD>(userData & 0xFFFFFFFF);
+            const auto generation = static_cast<uint32_t>(userData >> 32);
+            if (static_cast<size_t>(fd) >= mRegistrations.size())
+            {
+                continue;
+            }
+            auto& registration = mRegistrations[fd];
+            if (registration.channel == nullptr || registration.generation != generation)
+            {
+                // 已注销或已重新注册的fd的残留完成事件
+                continue;
+            }
+            if (res >= 0)
+            {
+                registration.failures = 0;
+            }
+            if (!(flags & IORING_CQE_F_MORE))
+            {
+                onPollTerminated(fd, registration, res);
+            }
+            if (res > 0)
+            {
+                callback(registration.channel, static_cast<uint32_t>(res));
+            }
+        }
+
+        return count;
+    }
+
+private:
+    struct Registration
+    {
+        void* channel = nullptr;
+        uint32_t generation = 0;
+        uint32_t events = 0;
+        // 连续注册失败的次数
+        uint32_t failures = 0;
+    };
+
+    // 同一fd连续注册失败达到此次数后放弃该fd
+    static const uint32_t sMaxArmFailures = 3;
+
+    IoUring() = default;
+
+    static int setup(unsigned int entries, struct io_uring_params* p)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+    }
+
+    static int enter(int fd, unsigned int toSubmit, unsigned int minComplete, unsigned int flags, const void* arg, size_t argSize)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize));
+    }
+
+    bool init(unsigned int entries)
+    {
+        struct io_uring_params p;
+        memset(&p, 0, sizeof(p));
+        p.flags = IORING_SETUP_CQSIZE;
+        p.cq_entries = entries * 4;
+
+        mRingFd = setup(entries, &p);
+        if (mRingFd < 0)
+        {
+            return false;
+        }
+
+        // 需要NODROP保证CQ不丢事件, EXT_ARG用于带超时的等待, RSRC_TAGS与multishot poll同一内核版本(5.13)引入
+        const unsigned int requireFeatures = IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG | IORING_FEAT_RSRC_TAGS;
+        if ((p.features & requireFeatures) != requireFeatures)
+        {
+            return false;
+        }
+
+        mSqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+        mCqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+        const bool singleMmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap)
+        {
+            mSqRingSize = mCqRingSize = std::max(mSqRingSize, mCqRingSize);
+        }
+
+        mSqRing = mmap(nullptr, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_SQ_RING);
+        if (mSqRing == MAP_FAILED)
+        {
+            return false;
+        }
+        if (singleMmap)
+        {
+            mCqRing = mSqRing;
+        }
+        else
+        {
+            mCqRing = mmap(nullptr, mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_CQ_RING);
+            if (mCqRing == MAP_FAILED)
+            {
+                return false;
+            }
+        }
+        mSqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+        mSqes = mmap(nullptr, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_SQES);
+        if (mSqes == MAP_FAILED)
+        {
+            return false;
+        }
+
+        auto sqRing = static_cast<char*>(mSqRing);
+        mSqHead = reinterpret_cast<unsigned int*>(sqRing + p.sq_off.head);
+        mSqTail = reinterpret_cast<unsigned int*>(sqRing + p.sq_off.tail);
+        mSqFlags = reinterpret_cast<unsigned int*>(sqRing + p.sq_off.flags);
+        mSqArray = reinterpret_cast<unsigned int*>(sqRing + p.sq_off.array);
+        mSqMask = *reinterpret_cast<unsigned int*>(sqRing + p.sq_off.ring_mask);
+        mSqEntries = p.sq_entries;
+        mSqLocalTail = *mSqTail;
+
+        auto cqRing = static_cast<char*>(mCqRing);
+        mCqHead = reinterpret_cast<unsigned int*>(cqRing + p.cq_off.head);
+        mCqTail = reinterpret_cast<unsigned int*>(cqRing + p.cq_off.tail);
+        mCqMask = *reinterpret_cast<unsigned int*>(cqRing + p.cq_off.ring_mask);
+        mCqes = reinterpret_cast<struct io_uring_cqe*>(cqRing + p.cq_off.cqes);
+
+        return true;
+    }
+
+    unsigned int pendingSubmit() const
+    {
+        return mSqLocalTail - __atomic_load_n(mSqHead, __ATOMIC_ACQUIRE);
+    }
+
+    struct io_uring_sqe* getSqe()
+    {
+        if (pendingSubmit() >= mSqEntries)
+        {
+            // SQ已满,先提交一次(不等待)
+            enter(0);
+            if (pendingSubmit() >= mSqEntries)
+            {
+                return nullptr;
+            }
+        }
+
+        const auto index = mSqLocalTail & mSqMask;
+        auto sqe = static_cast<struct io_uring_sqe*>(mSqes) + index;
+        memset(sqe, 0, sizeof(*sqe));
+        mSqArray[index] = index;
+        mSqLocalTail++;
+        __atomic_store_n(mSqTail, mSqLocalTail, __ATOMIC_RELEASE);
+
+        return sqe;
+    }
+
+    bool armPoll(BrynetSocketFD fd, uint32_t generation, uint32_t events)
+    {
+        auto sqe = getSqe();
+        if (sqe == nullptr)
+        {
+            return false;
+        }
+
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = fd;
+        sqe->len = IORING_POLL_ADD_MULTI;
+        sqe->poll32_events = events;
+        sqe->user_data = makeUserData(fd, generation);
+        return true;
+    }
+
+    // multishot poll结束且没有被注销/重新注册
+    void onPollTerminated(BrynetSocketFD fd, Registration& registration, int res)
+    {
+        if (res >= 0 || res == -ECANCELED)
+        {
+            // 被内核终止(例如CQ溢出),需要重新注册
+            armPoll(fd, registration.generation, registration.events);
+            return;
+        }
+        if (res == -EINVAL || res == -EOPNOTSUPP)
+        {
+            // 内核不支持multishot poll, 所有fd都会得到同样的错误
+            mArmError = -res;
+            return;
+        }
+        if (res == -EBADF || ++registration.failures >= sMaxArmFailures)
+        {
+            // fd已被关闭(与epoll一样, 关闭的fd自动失去注册), 或者反复失败, 只放弃该fd
+            registration.channel = nullptr;
+            registration.generation++;
+            registration.failures = 0;
+            return;
+        }
+        // 暂时性错误(例如ENOMEM), 重新注册该fd
+        armPoll(fd, registration.generation, registration.events);
+    }
+
+    void cancelPoll(BrynetSocketFD fd, uint32_t generation)
+    {
+        auto sqe = getSqe();
+        if (sqe == nullptr)
+        {
+            return;
+        }
+
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = makeUserData(fd, generation);
+        sqe->user_data = sCancelUserData;
+    }
+
+    void enter(int64_t milliseconds)
+    {
+        const auto toSubmit = pendingSubmit();
+        const bool cqEmpty = !hasCompletions();
+        const bool cqOverflow = (__atomic_load_n(mSqFlags, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW) != 0;
+        const bool needWait = milliseconds != 0 && cqEmpty;
+
+        if (toSubmit == 0 && !needWait && !cqOverflow)
+        {
+            return;
+        }
+
+        struct __kernel_timespec ts;
+        ts.tv_sec = milliseconds / 1000;
+        ts.tv_nsec = (milliseconds % 1000) * 1000 * 1000;
+
+        struct io_uring_getevents_arg arg;
+        memset(&arg, 0, sizeof(arg));
+        arg.sigmask_sz = _NSIG / 8;
+        arg.ts = milliseconds > 0 ? reinterpret_cast<uint64_t>(&ts) : 0;
+
+        unsigned int flags = IORING_ENTER_EXT_ARG;
+        if (needWait || cqOverflow)
+        {
+            flags |= IORING_ENTER_GETEVENTS;
+        }
+
+        // 返回ETIME/EINTR/EBUSY时, 已提交的SQE仍然有效, 直接收割CQ即可
+        (void) enter(mRingFd, toSubmit, needWait ? 1 : 0, flags, &arg, sizeof(arg));
+    }
+
+    static uint64_t makeUserData(BrynetSocketFD fd, uint32_t generation)
+    {
+        return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+    }
+
+private:
+    static const uint64_t sCancelUserData = ~static_cast<uint64_t>(0);
+
+    int mRingFd = -1;
+    int mArmError = 0;
+
+    void* mSqRing = MAP_FAILED;
+    void* mCqRing = MAP_FAILED;
+    void* mSqes = MAP_FAILED;
+    size_t mSqRingSize = 0;
+    size_t mCqRingSize = 0;
+    size_t mSqesSize = 0;
+
+    unsigned int* mSqHead = nullptr;
+    unsigned int* mSqTail = nullptr;
+    unsigned int* mSqFlags = nullptr;
+    unsigned int* mSqArray = nullptr;
+    unsigned int mSqMask = 0;
+    unsigned int mSqEntries = 0;
+    unsigned int mSqLocalTail = 0;
+
+    unsigned int* mCqHead = nullptr;
+    unsigned int* mCqTail = nullptr;
+    unsigned int mCqMask = 0;
+    struct io_uring_cqe* mCqes = nullptr;
+
+    std::vector<Registration> mRegistrations;
+};
+#endif
+
+}}}// namespace brynet::net::port
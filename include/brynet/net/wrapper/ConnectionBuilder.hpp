@@ -138,8 +138,10 @@ public:
         return static_cast<Derived&>(*this);
     }
 
+    // 连接失败或连接建立后创建TcpConnection失败时调用
     Derived& WithFailedCallback(FailedCallback callback)
     {
+        mOption.failedCallback = callback;
         mConnectBuilder.WithFailedCallback(std::move(callback));
         return static_cast<Derived&>(*this);
     }
@@ -156,6 +158,15 @@ public:
         mOption.useSSL = true;
         return static_cast<Derived&>(*this);
     }
+
+    // sslHelper为SSLHelper::initClientSSL初始化的共用上下文, serverName用于SNI及证书主机名校验
+    Derived& WithSSL(SSLHelper::Ptr sslHelper, std::string serverName = "")
+    {
+        mOption.useSSL = true;
+        mOption.sslHelper = std::move(sslHelper);
+        mOption.sslServerName = std::move(serverName);
+        return static_cast<Derived&>(*this);
+    }
 #endif
     Derived& WithForceSameThreadLoop()
     {
@@ -163,6 +174,12 @@ public:
         return static_cast<Derived&>(*this);
     }
 
+    Derived& WithLoopBalance(LoopBalance balance)
+    {
+        mOption.loopBalance = balance;
+        return static_cast<Derived&>(*this);
+    }
+
     Derived& AddEnterCallback(const TcpConnection::EnterCallback& callback)
     {
         mOption.enterCallback.push_back(callback);
@@ -188,6 +205,9 @@ public:
         option.enterCallback.push_back([sessionPromise](const TcpConnection::Ptr& session) {
             sessionPromise->set_value(session);
         });
+        option.failedCallback = [sessionPromise]() {
+            sessionPromise->set_value(nullptr);
+        };
 
         auto socket = mConnectBuilder.syncConnect();
         if (socket == nullptr || !mTcpService->addTcpConnection(std::move(socket), option))
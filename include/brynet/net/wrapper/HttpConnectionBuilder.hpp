@@ -63,6 +63,12 @@ public:
         mBuilder.WithSSL();
         return *this;
     }
+
+    HttpConnectionBuilder& WithSSL(SSLHelper::Ptr sslHelper, std::string serverName = "")
+    {
+        mBuilder.WithSSL(std::move(sslHelper), std::move(serverName));
+        return *this;
+    }
 #endif
     HttpConnectionBuilder& WithForceSameThreadLoop()
     {
@@ -70,6 +76,12 @@ public:
         return *this;
     }
 
+    HttpConnectionBuilder& WithLoopBalance(LoopBalance balance)
+    {
+        mBuilder.WithLoopBalance(balance);
+        return *this;
+    }
+
     void asyncConnect()
     {
         if (mHttpEnterCallback == nullptr)
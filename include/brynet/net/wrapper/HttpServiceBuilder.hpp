@@ -45,6 +45,12 @@ public:
         return *this;
     }
 
+    HttpListenerBuilder& WithLoopBalance(LoopBalance balance)
+    {
+        mBuilder.WithLoopBalance(balance);
+        return *this;
+    }
+
     HttpListenerBuilder& WithAddr(bool ipV6, std::string ip, size_t port)
     {
         mBuilder.WithAddr(ipV6, std::move(ip), port);
@@ -57,6 +63,12 @@ public:
         return *this;
     }
 
+    HttpListenerBuilder& WithReusePortPerLoop()
+    {
+        mBuilder.WithReusePortPerLoop();
+        return *this;
+    }
+
     void asyncRun()
     {
         if (mHttpEnterCallback == nullptr)
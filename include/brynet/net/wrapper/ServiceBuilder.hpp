@@ -2,6 +2,7 @@
 
 #include <brynet/net/Exception.hpp>
 #include <brynet/net/ListenThread.hpp>
+#include <brynet/net/LoopListener.hpp>
 #include <brynet/net/TcpService.hpp>
 #include <brynet/net/detail/ConnectionOption.hpp>
 #include <utility>
@@ -34,6 +35,15 @@ public:
         return static_cast<Derived&>(*this);
     }
 
+    // 每个工作线程的EventLoop各自监听(SO_REUSEPORT)并在loop内accept, 不再使用独立的监听线程.
+    // 需要在asyncRun之前开启TcpService的工作线程, Windows下仍使用监听线程
+    Derived& WithReusePortPerLoop()
+    {
+        mEnabledReusePort = true;
+        mListenPerLoop = true;
+        return static_cast<Derived&>(*this);
+    }
+
     Derived& AddSocketProcess(const ListenThread::TcpSocketProcessCallback& callback)
     {
         mSocketProcessCallbacks.push_back(callback);
@@ -59,6 +69,12 @@ public:
         return static_cast<Derived&>(*this);
     }
 
+    Derived& WithLoopBalance(LoopBalance balance)
+    {
+        mSocketOption.loopBalance = balance;
+        return static_cast<Derived&>(*this);
+    }
+
     Derived& AddEnterCallback(const TcpConnection::EnterCallback& callback)
     {
         mSocketOption.enterCallback.push_back(callback);
@@ -78,6 +94,24 @@ public:
 
         auto service = mTcpService;
         auto option = mSocketOption;
+#ifndef BRYNET_PLATFORM_WINDOWS
+        if (mListenPerLoop)
+        {
+            // 新连接由accept它的loop处理
+            option.forceSameThreadLoop = true;
+            mLoopListener = LoopListener::Create(
+                    service,
+                    mIsIpV6,
+                    mListenAddr,
+                    mPort,
+                    [service, option](brynet::net::TcpSocket::Ptr socket) {
+                        service->addTcpConnection(std::move(socket), option);
+                    },
+                    mSocketProcessCallbacks);
+            mLoopListener->startListen();
+            return;
+        }
+#endif
         mListenThread = ListenThread::Create(
                 mIsIpV6,
                 mListenAddr,
@@ -96,6 +130,10 @@ public:
         {
             mListenThread->stopListen();
         }
+        if (mLoopListener)
+        {
+            mLoopListener->stopListen();
+        }
     }
 
 private:
@@ -106,7 +144,9 @@ private:
     int mPort = 0;
     bool mIsIpV6 = false;
     bool mEnabledReusePort = false;
+    bool mListenPerLoop = false;
     ListenThread::Ptr mListenThread;
+    LoopListener::Ptr mLoopListener;
 };
 
 class ListenerBuilder : public BaseListenerBuilder<ListenerBuilder>
@@ -0,0 +1,99 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <atomic>
+#include <brynet/net/wrapper/ConnectionBuilder.hpp>
+#include <brynet/net/wrapper/ServiceBuilder.hpp>
+#include <future>
+#include <thread>
+
+#include "catch.hpp"
+
+TEST_CASE("TcpConnection coalesce small messages", "[coalesce]")
+{
+    using namespace brynet::net;
+
+    const std::string ip = "127.0.0.1";
+    const auto port = 9993;
+
+    auto service = TcpService::Create();
+    service->startWorkerThread(1);
+
+    std::mutex recvGuard;
+    std::string recvData;
+    wrapper::ListenerBuilder listener;
+    listener.WithService(service)
+            .WithAddr(false, ip, port)
+            .WithMaxRecvBufferSize(64 * 1024)
+            .AddEnterCallback([&](const TcpConnection::Ptr& session) {
+                session->setDataCallback([&](brynet::base::BasePacketReader& reader) {
+                    std::lock_guard<std::mutex> lck(recvGuard);
+                    recvData.append(reader.begin(), reader.size());
+                    reader.consumeAll();
+                });
+            })
+            .asyncRun();
+
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+    wrapper::ConnectionBuilder connectionBuilder;
+    auto session = connectionBuilder
+                           .WithService(service)
+                           .WithConnector(connector)
+                           .WithTimeout(std::chrono::seconds(2))
+                           .WithAddr(ip, port)
+                           .syncConnect();
+    REQUIRE(session != nullptr);
+    session->setCoalesceThreshold(128);
+
+    std::string expectData;
+    std::atomic<size_t> completeCount{0};
+    std::string big(200 * 1024, 'b');
+
+    // 在loop线程中一次性投递, 让短消息真正在同一个合并缓冲区中排队
+    std::promise<void> sended;
+    session->getEventLoop()->runAsyncFunctor([&]() {
+        for (size_t i = 0; i < 100000; i++)
+        {
+            const auto s = "msg" + std::to_string(i) + ";";
+            session->send(s);
+            expectData += s;
+
+            if (i % 10000 == 0)
+            {
+                // 大消息不拷贝, 带回调的短消息不合并, 都与合并的短消息保持顺序
+                session->send(big);
+                expectData += big;
+                session->send(MakeStringMsg("cb"), [&completeCount]() {
+                    completeCount++;
+                });
+                expectData += "cb";
+            }
+        }
+        sended.set_value();
+    });
+    sended.get_future().wait();
+
+    for (int i = 0; i < 500; i++)
+    {
+        {
+            std::lock_guard<std::mutex> lck(recvGuard);
+            if (recvData.size() >= expectData.size())
+            {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(recvGuard);
+        REQUIRE(recvData.size() == expectData.size());
+        REQUIRE(recvData == expectData);
+    }
+    REQUIRE(completeCount == 10);
+
+    listener.stop();
+    session->postDisConnect();
+    session.reset();
+    service->stopWorkerThread();
+    connector->stopWorkerThread();
+}
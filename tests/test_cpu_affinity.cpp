@@ -0,0 +1,34 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <brynet/base/CpuAffinity.hpp>
+#include <set>
+
+#include "catch.hpp"
+
+TEST_CASE("CpuAffinity are computed", "[cpu_affinity]")
+{
+    using namespace brynet::base;
+
+    const auto layout = GetCpuLayout();
+    REQUIRE_FALSE(layout.empty());
+
+    std::set<int> cpus;
+    for (const auto& info : layout)
+    {
+        cpus.insert(info.cpu);
+        REQUIRE(GetCpuNumaNode(info.cpu) == info.numaNode);
+    }
+
+    const size_t threadNum = layout.size() * 2 + 1;
+    const auto cpuSets = MakeSpreadCpuSets(threadNum);
+    REQUIRE(cpuSets.size() == threadNum);
+    for (const auto& cpuSet : cpuSets)
+    {
+        REQUIRE(cpuSet.size() == 1);
+        REQUIRE(cpus.count(cpuSet.front()) == 1);
+    }
+
+    REQUIRE_FALSE(SetCurrentThreadAffinity({}));
+#ifndef BRYNET_PLATFORM_DARWIN
+    REQUIRE(SetCurrentThreadAffinity(cpuSets.front()));
+#endif
+}
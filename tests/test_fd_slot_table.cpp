@@ -0,0 +1,52 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <brynet/net/detail/FdSlotTable.hpp>
+#include <memory>
+
+#include "catch.hpp"
+
+TEST_CASE("FdSlotTable are computed", "[fd_slot_table]")
+{
+    using namespace brynet::net::detail;
+
+    FdSlotTable<std::shared_ptr<int>> table;
+    REQUIRE(table.size() == 0);
+    REQUIRE(table.findByFd(3) == nullptr);
+    REQUIRE(table.findByHandle(FdSlotTable<std::shared_ptr<int>>::sInvalidHandle) == nullptr);
+    REQUIRE_FALSE(table.erase(3));
+
+    auto value = std::make_shared<int>(1);
+    const auto handle = table.insert(3, value);
+    REQUIRE(table.size() == 1);
+    REQUIRE(table.findByFd(3) != nullptr);
+    REQUIRE(*table.findByFd(3) == value);
+    REQUIRE(table.findByHandle(handle) != nullptr);
+    REQUIRE(table.findByFd(2) == nullptr);
+    REQUIRE(value.use_count() == 2);
+
+    // grows on demand
+    table.insert(1000, std::make_shared<int>(2));
+    REQUIRE(table.size() == 2);
+    REQUIRE(**table.findByFd(1000) == 2);
+    REQUIRE(*table.findByHandle(handle) == value);
+
+    // erase releases the value and invalidates the handle
+    REQUIRE(table.erase(3));
+    REQUIRE(table.size() == 1);
+    REQUIRE(value.use_count() == 1);
+    REQUIRE(table.findByFd(3) == nullptr);
+    REQUIRE(table.findByHandle(handle) == nullptr);
+
+    // a reused fd gets a new handle, and the stale handle stays invalid
+    const auto newHandle = table.insert(3, std::make_shared<int>(3));
+    REQUIRE(newHandle != handle);
+    REQUIRE(table.findByHandle(handle) == nullptr);
+    REQUIRE(**table.findByHandle(newHandle) == 3);
+    REQUIRE(**table.findByFd(3) == 3);
+
+    // negative fd is rejected
+    const auto invalidHandle = FdSlotTable<std::shared_ptr<int>>::sInvalidHandle;
+    REQUIRE(table.insert(-1, std::make_shared<int>(4)) == invalidHandle);
+    REQUIRE(table.size() == 2);
+    REQUIRE(table.findByFd(-1) == nullptr);
+    REQUIRE_FALSE(table.erase(-1));
+}
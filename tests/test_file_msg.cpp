@@ -0,0 +1,103 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <atomic>
+#include <brynet/net/wrapper/ConnectionBuilder.hpp>
+#include <brynet/net/wrapper/ServiceBuilder.hpp>
+#include <cstdio>
+#include <thread>
+
+#include "catch.hpp"
+
+TEST_CASE("TcpConnection send file region", "[file_msg]")
+{
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+    using namespace brynet::net;
+
+    const std::string ip = "127.0.0.1";
+    const auto port = 9991;
+    const size_t fileLen = 8 * 1024 * 1024;
+
+    std::string fileData;
+    fileData.reserve(fileLen);
+    for (size_t i = 0; i < fileLen; i++)
+    {
+        fileData.push_back(static_cast<char>('a' + (i * 7) % 26));
+    }
+    auto file = tmpfile();
+    REQUIRE(file != nullptr);
+    REQUIRE(fwrite(fileData.data(), 1, fileData.size(), file) == fileData.size());
+    fflush(file);
+    const auto fd = fileno(file);
+
+    auto service = TcpService::Create();
+    service->startWorkerThread(1);
+
+    std::mutex recvGuard;
+    std::string recvData;
+    wrapper::ListenerBuilder listener;
+    listener.WithService(service)
+            .WithAddr(false, ip, port)
+            .WithMaxRecvBufferSize(64 * 1024)
+            .AddEnterCallback([&](const TcpConnection::Ptr& session) {
+                session->setDataCallback([&](brynet::base::BasePacketReader& reader) {
+                    std::lock_guard<std::mutex> lck(recvGuard);
+                    recvData.append(reader.begin(), reader.size());
+                    reader.consumeAll();
+                });
+            })
+            .asyncRun();
+
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+    wrapper::ConnectionBuilder connectionBuilder;
+    auto session = connectionBuilder
+                           .WithService(service)
+                           .WithConnector(connector)
+                           .WithTimeout(std::chrono::seconds(2))
+                           .WithAddr(ip, port)
+                           .syncConnect();
+    REQUIRE(session != nullptr);
+
+    // 文件区间消息与内存消息按顺序交错发送
+    std::string expectData;
+    std::atomic<size_t> completeCount{0};
+    auto onComplete = [&completeCount]() {
+        completeCount++;
+    };
+    session->send(MakeStringMsg("head"), onComplete);
+    expectData += "head";
+    session->send(MakeFileMsg(fd, 100, 1000), onComplete);
+    expectData += fileData.substr(100, 1000);
+    session->send(MakeStringMsg("middle"), onComplete);
+    expectData += "middle";
+    session->send(MakeFileMsg(fd, 0, fileLen), onComplete);
+    expectData += fileData;
+    session->send(MakeStringMsg("tail"), onComplete);
+    expectData += "tail";
+
+    for (int i = 0; i < 500; i++)
+    {
+        {
+            std::lock_guard<std::mutex> lck(recvGuard);
+            if (recvData.size() >= expectData.size())
+            {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(recvGuard);
+        REQUIRE(recvData.size() == expectData.size());
+        REQUIRE(recvData == expectData);
+    }
+    REQUIRE(completeCount == 5);
+
+    listener.stop();
+    session->postDisConnect();
+    session.reset();
+    service->stopWorkerThread();
+    connector->stopWorkerThread();
+    fclose(file);
+#endif
+}
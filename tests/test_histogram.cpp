@@ -0,0 +1,48 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <brynet/base/Histogram.hpp>
+#include <cstdint>
+
+#include "catch.hpp"
+
+TEST_CASE("Histogram are computed", "[histogram]")
+{
+    using namespace brynet::base;
+
+    {
+        Histogram histogram;
+        auto snapshot = histogram.snapshot();
+        REQUIRE(snapshot.count == 0);
+        REQUIRE(snapshot.percentile(99) == 0);
+        REQUIRE(snapshot.mean() == 0);
+    }
+
+    // bucket upper bound is never below the value, and relative error is within 1/8
+    for (uint64_t value = 0; value < 100000; value += 7)
+    {
+        const auto upper = Histogram::bucketUpperBound(Histogram::bucketIndex(value));
+        REQUIRE(upper >= value);
+        REQUIRE(upper - value <= value / 8);
+    }
+    REQUIRE(Histogram::bucketIndex(UINT64_MAX) == Histogram::sBucketNum - 1);
+
+    {
+        Histogram histogram;
+        for (uint64_t i = 1; i <= 1000; i++)
+        {
+            histogram.record(i);
+        }
+        auto snapshot = histogram.snapshot();
+        REQUIRE(snapshot.count == 1000);
+        REQUIRE(snapshot.sum == 500500);
+        REQUIRE(snapshot.max == 1000);
+        REQUIRE(snapshot.mean() == Approx(500.5));
+
+        const auto p50 = snapshot.percentile(50);
+        REQUIRE(p50 >= 500);
+        REQUIRE(p50 <= 500 + 500 / 8);
+        const auto p99 = snapshot.percentile(99);
+        REQUIRE(p99 >= 990);
+        REQUIRE(p99 <= 1000);
+        REQUIRE(snapshot.percentile(100) == 1000);
+    }
+}
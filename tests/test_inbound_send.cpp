@@ -0,0 +1,211 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <atomic>
+#include <brynet/net/wrapper/ConnectionBuilder.hpp>
+#include <brynet/net/wrapper/ServiceBuilder.hpp>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+
+TEST_CASE("TcpConnection send from multiple threads", "[inbound_send]")
+{
+    using namespace brynet::net;
+
+    const std::string ip = "127.0.0.1";
+    const auto port = 9997;
+    const int threadNum = 4;
+    const int msgNum = 50000;
+
+    auto service = TcpService::Create();
+    service->startWorkerThread(1);
+
+    std::mutex recvGuard;
+    std::string recvData;
+    std::atomic_bool peerClosed{false};
+    wrapper::ListenerBuilder listener;
+    listener.WithService(service)
+            .WithAddr(false, ip, port)
+            .WithMaxRecvBufferSize(64 * 1024)
+            .AddEnterCallback([&](const TcpConnection::Ptr& session) {
+                session->setDataCallback([&](brynet::base::BasePacketReader& reader) {
+                    std::lock_guard<std::mutex> lck(recvGuard);
+                    recvData.append(reader.begin(), reader.size());
+                    reader.consumeAll();
+                });
+                session->setDisConnectCallback([&](const TcpConnection::Ptr&) {
+                    peerClosed = true;
+                });
+            })
+            .asyncRun();
+
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+    wrapper::ConnectionBuilder connectionBuilder;
+    auto session = connectionBuilder
+                           .WithService(service)
+                           .WithConnector(connector)
+                           .WithTimeout(std::chrono::seconds(2))
+                           .WithAddr(ip, port)
+                           .syncConnect();
+    REQUIRE(session != nullptr);
+    REQUIRE_FALSE(session->getEventLoop()->isInLoopThread());
+
+    // 每条消息为固定长度的"线程号,序号;"
+    auto makeMsg = [](int thread, int index) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%d,%07d;", thread, index);
+        return std::string(buf);
+    };
+
+    std::atomic<int> completeCount{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadNum; t++)
+    {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < msgNum; i++)
+            {
+                session->send(makeMsg(t, i), [&completeCount]() {
+                    completeCount++;
+                });
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    // 在send之后投递的关闭操作不能早于之前的消息
+    session->postShutdown();
+
+    for (int i = 0; i < 500 && !peerClosed; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE(peerClosed);
+    REQUIRE(completeCount == threadNum * msgNum);
+
+    {
+        std::lock_guard<std::mutex> lck(recvGuard);
+        const auto msgLen = makeMsg(0, 0).size();
+        REQUIRE(recvData.size() == threadNum * msgNum * msgLen);
+
+        // 同一个线程发送的消息保持顺序
+        std::vector<int> nextIndex(threadNum, 0);
+        for (size_t pos = 0; pos < recvData.size(); pos += msgLen)
+        {
+            const auto thread = recvData[pos] - '0';
+            REQUIRE(thread >= 0);
+            REQUIRE(thread < threadNum);
+            REQUIRE(recvData.compare(pos, msgLen, makeMsg(thread, nextIndex[thread])) == 0);
+            nextIndex[thread]++;
+        }
+    }
+
+    listener.stop();
+    session->postDisConnect();
+    session.reset();
+    service->stopWorkerThread();
+    connector->stopWorkerThread();
+}
+
+TEST_CASE("TcpConnection shutdown after send from another thread", "[inbound_send]")
+{
+    using namespace brynet::net;
+
+    const std::string ip = "127.0.0.1";
+    const auto port = 9979;
+    const int roundNum = 100;
+    const int noiseThreadNum = 4;
+
+    auto service = TcpService::Create();
+    service->startWorkerThread(1);
+
+    std::mutex resultGuard;
+    std::vector<std::string> results;
+    wrapper::ListenerBuilder listener;
+    listener.WithService(service)
+            .WithAddr(false, ip, port)
+            .WithMaxRecvBufferSize(64 * 1024)
+            .AddEnterCallback([&](const TcpConnection::Ptr& session) {
+                auto recvData = std::make_shared<std::string>();
+                session->setDataCallback([recvData](brynet::base::BasePacketReader& reader) {
+                    recvData->append(reader.begin(), reader.size());
+                    reader.consumeAll();
+                });
+                session->setDisConnectCallback([&, recvData](const TcpConnection::Ptr&) {
+                    std::lock_guard<std::mutex> lck(resultGuard);
+                    results.push_back(*recvData);
+                });
+            })
+            .asyncRun();
+
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+
+    for (int round = 0; round < roundNum; round++)
+    {
+        wrapper::ConnectionBuilder connectionBuilder;
+        auto session = connectionBuilder
+                               .WithService(service)
+                               .WithConnector(connector)
+                               .WithTimeout(std::chrono::seconds(2))
+                               .WithAddr(ip, port)
+                               .syncConnect();
+        REQUIRE(session != nullptr);
+
+        // 其他线程同时发送, 与最后一条消息争用投递
+        std::atomic_bool start{false};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < noiseThreadNum; t++)
+        {
+            threads.emplace_back([&]() {
+                while (!start)
+                {
+                }
+                for (int i = 0; i < 100; i++)
+                {
+                    session->send("n");
+                }
+            });
+        }
+        threads.emplace_back([&]() {
+            while (!start)
+            {
+            }
+            session->send("first;");
+            session->send("last;");
+            // 同一线程先send后shutdown, 之前的消息必须全部发出
+            session->postShutdown();
+        });
+        start = true;
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (int i = 0; i < 500; i++)
+        {
+            {
+                std::lock_guard<std::mutex> lck(resultGuard);
+                if (results.size() == static_cast<size_t>(round + 1))
+                {
+                    break;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        {
+            std::lock_guard<std::mutex> lck(resultGuard);
+            REQUIRE(results.size() == static_cast<size_t>(round + 1));
+            const auto& recvData = results.back();
+            const auto firstPos = recvData.find("first;");
+            REQUIRE(firstPos != std::string::npos);
+            REQUIRE(recvData.find("last;", firstPos) != std::string::npos);
+        }
+        session->postDisConnect();
+    }
+
+    listener.stop();
+    service->stopWorkerThread();
+    connector->stopWorkerThread();
+}
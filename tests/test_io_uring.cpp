@@ -0,0 +1,159 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <atomic>
+#include <brynet/net/wrapper/ConnectionBuilder.hpp>
+#include <brynet/net/wrapper/ServiceBuilder.hpp>
+#include <thread>
+
+#include "catch.hpp"
+
+static bool WaitFor(const std::function<bool()>& condition)
+{
+    for (int i = 0; i < 500 && !condition(); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return condition();
+}
+
+#if defined BRYNET_PLATFORM_LINUX && defined BRYNET_USE_IO_URING
+TEST_CASE("IoUring drops only the channel whose poll failed", "[io_uring]")
+{
+    using namespace brynet::net;
+
+    auto ring = port::IoUring::Create(64);
+    if (ring == nullptr)
+    {
+        WARN("io_uring is not supported by the kernel, skipped");
+        return;
+    }
+
+    int pipeFds[2];
+    REQUIRE(pipe(pipeFds) == 0);
+    int pipeChannel = 0;
+    REQUIRE(ring->addChannel(pipeFds[0], &pipeChannel, EPOLLIN | EPOLLET));
+
+    // 已关闭的fd注册poll会得到EBADF
+    const auto fd = socket(AF_INET, SOCK_STREAM, 0);
+    REQUIRE(fd >= 0);
+    close(fd);
+    int dummy = 0;
+    REQUIRE(ring->addChannel(fd, &dummy, EPOLLIN));
+    ring->submitAndWait(1000);
+    REQUIRE(ring->processCompletions([](void*, uint32_t) {
+        FAIL("no event expected");
+    }) == 1);
+    // 只放弃该fd, 不回退整个引擎
+    REQUIRE(ring->armError() == 0);
+    size_t channelNum = 0;
+    ring->foreachChannel([&](BrynetSocketFD, void* channel, uint32_t) {
+        REQUIRE(channel == &pipeChannel);
+        channelNum++;
+    });
+    REQUIRE(channelNum == 1);
+
+    // 没有重新注册, 不会再产生完成事件
+    ring->submitAndWait(0);
+    REQUIRE_FALSE(ring->hasCompletions());
+
+    // 其他fd照常收到事件
+    REQUIRE(write(pipeFds[1], "x", 1) == 1);
+    ring->submitAndWait(1000);
+    void* readyChannel = nullptr;
+    ring->processCompletions([&](void* channel, uint32_t events) {
+        REQUIRE((events & EPOLLIN) != 0);
+        readyChannel = channel;
+    });
+    REQUIRE(readyChannel == &pipeChannel);
+
+    close(pipeFds[0]);
+    close(pipeFds[1]);
+}
+#endif
+
+TEST_CASE("TcpService echo over io_uring", "[io_uring]")
+{
+    using namespace brynet::net;
+
+    const std::string ip = "127.0.0.1";
+    const auto port = 9980;
+
+    EventLoopOption option;
+    option.useIoUring = true;
+    auto service = TcpService::Create();
+    service->startWorkerThread(1, nullptr, option);
+    if (!service->getRandomEventLoop()->isIoUringEnabled())
+    {
+        WARN("io_uring is not supported, skipped");
+        service->stopWorkerThread();
+        return;
+    }
+
+    wrapper::ListenerBuilder listener;
+    listener.WithService(service)
+            .WithAddr(false, ip, port)
+            .WithMaxRecvBufferSize(64 * 1024)
+            .AddEnterCallback([](const TcpConnection::Ptr& session) {
+                session->setDataCallback([session](brynet::base::BasePacketReader& reader) {
+                    session->send(reader.begin(), reader.size());
+                    reader.consumeAll();
+                });
+            })
+            .asyncRun();
+
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+
+    std::mutex recvGuard;
+    std::string recvData;
+    std::atomic_bool closed{false};
+    wrapper::ConnectionBuilder connectionBuilder;
+    auto session = connectionBuilder
+                           .WithService(service)
+                           .WithConnector(connector)
+                           .WithTimeout(std::chrono::seconds(2))
+                           .WithAddr(ip, port)
+                           .WithMaxRecvBufferSize(64 * 1024)
+                           .AddEnterCallback([&](const TcpConnection::Ptr& session) {
+                               session->setDataCallback([&](brynet::base::BasePacketReader& reader) {
+                                   std::lock_guard<std::mutex> lck(recvGuard);
+                                   recvData.append(reader.begin(), reader.size());
+                                   reader.consumeAll();
+                               });
+                               session->setDisConnectCallback([&](const TcpConnection::Ptr&) {
+                                   closed = true;
+                               });
+                           })
+                           .syncConnect();
+    REQUIRE(session != nullptr);
+
+    // 小消息与超过socket缓冲区的大消息(需要等待可写事件)都能完整回显
+    std::string expectData;
+    for (int i = 0; i < 100; i++)
+    {
+        const std::string msg(100 + i, static_cast<char>('a' + i % 26));
+        session->send(msg);
+        expectData += msg;
+    }
+    const std::string bigMsg(8 * 1024 * 1024, 'b');
+    session->send(bigMsg);
+    expectData += bigMsg;
+
+    REQUIRE(WaitFor([&]() {
+        std::lock_guard<std::mutex> lck(recvGuard);
+        return recvData.size() >= expectData.size();
+    }));
+    {
+        std::lock_guard<std::mutex> lck(recvGuard);
+        REQUIRE(recvData == expectData);
+    }
+    REQUIRE(service->getRandomEventLoop()->isIoUringEnabled());
+
+    listener.stop();
+    session->postDisConnect();
+    REQUIRE(WaitFor([&]() {
+        return closed.load();
+    }));
+
+    service->stopWorkerThread();
+    connector->stopWorkerThread();
+}
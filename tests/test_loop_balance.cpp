@@ -0,0 +1,134 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <brynet/base/CpuAffinity.hpp>
+#include <brynet/net/TcpService.hpp>
+#include <future>
+#include <set>
+
+#include "catch.hpp"
+
+TEST_CASE("Loop balance strategy", "[loop_balance]")
+{
+    using namespace brynet::net;
+
+    auto service = TcpService::Create();
+    REQUIRE(service->selectEventLoop(LoopBalance::RoundRobin) == nullptr);
+
+    service->startWorkerThread(3);
+
+    {
+        std::set<EventLoop::Ptr> eventLoops;
+        for (size_t i = 0; i < 3; i++)
+        {
+            eventLoops.insert(service->selectEventLoop(LoopBalance::RoundRobin));
+        }
+        REQUIRE(eventLoops.size() == 3);
+        REQUIRE(eventLoops.count(nullptr) == 0);
+    }
+
+    for (auto balance : {LoopBalance::Random,
+                         LoopBalance::LeastConnections,
+                         LoopBalance::LeastPendingBytes,
+                         LoopBalance::PowerOfTwoChoices})
+    {
+        REQUIRE(service->selectEventLoop(balance) != nullptr);
+    }
+
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+    // 每次都选择连接数最少的EventLoop, 6个连接应当平均分配
+    std::vector<int> peers;
+    ConnectionOption option;
+    option.loopBalance = LoopBalance::LeastConnections;
+    for (size_t i = 0; i < 6; i++)
+    {
+        int fds[2];
+        REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        peers.push_back(fds[1]);
+        REQUIRE(service->addTcpConnection(TcpSocket::Create(fds[0], false), option));
+    }
+
+    std::set<EventLoop::Ptr> eventLoops;
+    for (size_t i = 0; i < 3; i++)
+    {
+        eventLoops.insert(service->selectEventLoop(LoopBalance::RoundRobin));
+    }
+    for (const auto& eventLoop : eventLoops)
+    {
+        REQUIRE(eventLoop->getConnectionNum() == 2);
+        REQUIRE(eventLoop->getPendingSendBytes() == 0);
+    }
+
+    for (auto fd : peers)
+    {
+        close(fd);
+    }
+#endif
+
+    service->stopWorkerThread();
+    REQUIRE(service->selectEventLoop(LoopBalance::Random) == nullptr);
+}
+
+TEST_CASE("Worker loops pinned to cpu sets", "[loop_balance]")
+{
+    using namespace brynet::net;
+
+    const auto layout = brynet::base::GetCpuLayout();
+    REQUIRE_FALSE(layout.empty());
+
+    EventLoopOption loopOption;
+    loopOption.cpuSets = {{layout.front().cpu}};
+    loopOption.preferLocalNumaLoop = true;
+    auto service = TcpService::Create();
+    service->startWorkerThread(2, nullptr, loopOption);
+
+    const auto numaNodes = service->getEventLoopNumaNodes();
+    REQUIRE(numaNodes.size() == 2);
+    for (auto node : numaNodes)
+    {
+        REQUIRE(node == layout.front().numaNode);
+    }
+    // 所有工作线程在同一个节点上, 仍然在全部EventLoop中选择
+    std::set<EventLoop::Ptr> eventLoops;
+    for (size_t i = 0; i < 2; i++)
+    {
+        eventLoops.insert(service->selectEventLoop(LoopBalance::RoundRobin));
+    }
+    REQUIRE(eventLoops.size() == 2);
+    REQUIRE(eventLoops.count(nullptr) == 0);
+
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+    // 连接在工作线程内创建
+    {
+        int fds[2];
+        REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        std::promise<bool> enterPromise;
+        ConnectionOption option;
+        option.enterCallback.push_back([&](const TcpConnection::Ptr& session) {
+            enterPromise.set_value(session->getEventLoop()->isInLoopThread());
+        });
+        REQUIRE(service->addTcpConnection(TcpSocket::Create(fds[0], false), option));
+        REQUIRE(enterPromise.get_future().get());
+        close(fds[1]);
+    }
+
+#ifdef BRYNET_USE_OPENSSL
+    // 在工作线程内创建失败时通过failedCallback通知
+    {
+        int fds[2];
+        REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        std::promise<void> failedPromise;
+        ConnectionOption option;
+        option.useSSL = true;
+        // 未初始化的SSLHelper, 服务端连接创建SSL失败
+        option.sslHelper = SSLHelper::Create();
+        option.failedCallback = [&]() {
+            failedPromise.set_value();
+        };
+        REQUIRE(service->addTcpConnection(TcpSocket::Create(fds[0], true), option));
+        REQUIRE(failedPromise.get_future().wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+        close(fds[1]);
+    }
+#endif
+#endif
+
+    service->stopWorkerThread();
+}
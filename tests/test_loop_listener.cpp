@@ -0,0 +1,80 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <atomic>
+#include <brynet/net/wrapper/ConnectionBuilder.hpp>
+#include <brynet/net/wrapper/ServiceBuilder.hpp>
+#include <thread>
+
+#include "catch.hpp"
+
+TEST_CASE("LoopListener accept in event loop", "[loop_listener]")
+{
+#ifndef BRYNET_PLATFORM_WINDOWS
+    using namespace brynet::net;
+
+    const std::string ip = "127.0.0.1";
+    const auto port = 9998;
+    const size_t connectionNum = 100;
+
+    auto service = TcpService::Create();
+    service->startWorkerThread(2);
+
+    std::atomic<size_t> enterCount{0};
+    std::atomic<size_t> inLoopCount{0};
+    std::atomic<size_t> ipCount{0};
+    wrapper::ListenerBuilder listener;
+    listener.WithService(service)
+            .WithAddr(false, ip, port)
+            .WithReusePortPerLoop()
+            .AddEnterCallback([&](const TcpConnection::Ptr& session) {
+                if (session->getEventLoop()->isInLoopThread())
+                {
+                    inLoopCount++;
+                }
+                // 对端地址来自accept4返回的地址
+                if (session->getIP() == ip)
+                {
+                    ipCount++;
+                }
+                enterCount++;
+            })
+            .asyncRun();
+
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+
+    std::vector<TcpSocket::Ptr> sockets;
+    for (size_t i = 0; i < connectionNum; i++)
+    {
+        wrapper::SocketConnectBuilder connectBuilder;
+        auto socket = connectBuilder
+                              .WithConnector(connector)
+                              .WithTimeout(std::chrono::seconds(2))
+                              .WithAddr(ip, port)
+                              .syncConnect();
+        REQUIRE(socket != nullptr);
+        sockets.push_back(std::move(socket));
+    }
+
+    for (int i = 0; i < 200 && enterCount < connectionNum; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE(enterCount == connectionNum);
+    REQUIRE(inLoopCount == connectionNum);
+    REQUIRE(ipCount == connectionNum);
+
+    listener.stop();
+    {
+        wrapper::SocketConnectBuilder connectBuilder;
+        auto socket = connectBuilder
+                              .WithConnector(connector)
+                              .WithTimeout(std::chrono::seconds(2))
+                              .WithAddr(ip, port)
+                              .syncConnect();
+        REQUIRE(socket == nullptr);
+    }
+
+    sockets.clear();
+    service->stopWorkerThread();
+#endif
+}
@@ -0,0 +1,80 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <brynet/base/MoveOnlyFunction.hpp>
+#include <array>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "catch.hpp"
+
+TEST_CASE("MoveOnlyFunction are computed", "[move_only_function]")
+{
+    using namespace brynet::base;
+    using Function = MoveOnlyFunction<int(int)>;
+
+    Function empty;
+    REQUIRE(empty == nullptr);
+    REQUIRE_FALSE(empty);
+    REQUIRE_THROWS_AS(empty(1), std::bad_function_call);
+
+    std::function<int(int)> emptyStdFunction;
+    Function fromEmpty = emptyStdFunction;
+    REQUIRE(fromEmpty == nullptr);
+
+    // small callable is stored inline
+    auto counter = std::make_shared<int>(0);
+    Function small = [counter](int v) {
+        *counter += v;
+        return *counter;
+    };
+    REQUIRE(small != nullptr);
+    REQUIRE(small.isInlineStored());
+    REQUIRE(small(2) == 2);
+
+    // moving keeps the target, and the source becomes empty
+    Function moved = std::move(small);
+    REQUIRE(small == nullptr);
+    REQUIRE(moved(3) == 5);
+    REQUIRE(counter.use_count() == 2);
+    moved = nullptr;
+    REQUIRE(counter.use_count() == 1);
+
+    // large callable falls back to heap
+    std::array<char, 128> large{};
+    large[0] = 7;
+    Function big = [large](int v) {
+        return large[0] + v;
+    };
+    REQUIRE_FALSE(big.isInlineStored());
+    REQUIRE(big(1) == 8);
+    Function bigMoved = std::move(big);
+    REQUIRE(bigMoved(2) == 9);
+
+    // move-only callable
+    std::unique_ptr<int> ptr(new int(10));
+    struct MoveOnlyCallable
+    {
+        std::unique_ptr<int> value;
+        int operator()(int v)
+        {
+            return *value + v;
+        }
+    };
+    Function moveOnly = MoveOnlyCallable{std::move(ptr)};
+    REQUIRE(moveOnly(1) == 11);
+
+    std::vector<Function> functions;
+    for (int i = 0; i < 100; i++)
+    {
+        functions.emplace_back([i, counter](int v) {
+            return i + v;
+        });
+    }
+    REQUIRE(counter.use_count() == 101);
+    for (int i = 0; i < 100; i++)
+    {
+        REQUIRE(functions[i](1) == i + 1);
+    }
+    functions.clear();
+    REQUIRE(counter.use_count() == 1);
+}
@@ -0,0 +1,180 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <brynet/base/MPSCQueue.hpp>
+#include <brynet/base/MPSCRingQueue.hpp>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+
+TEST_CASE("MPSCQueue are computed", "[mpsc_queue]")
+{
+    using namespace brynet::base;
+
+    {
+        MPSCQueue<int> queue;
+        int value = 0;
+        REQUIRE(queue.empty());
+        REQUIRE_FALSE(queue.pop(value));
+
+        queue.push(1);
+        queue.push(2);
+        REQUIRE_FALSE(queue.empty());
+        REQUIRE(queue.pop(value));
+        REQUIRE(value == 1);
+        REQUIRE(queue.pop(value));
+        REQUIRE(value == 2);
+        REQUIRE(queue.empty());
+    }
+
+    {
+        MPSCQueue<int> queue;
+        queue.push(1);
+        queue.push(2);
+
+        std::vector<int> values;
+        const auto count = queue.popAll([&](int v) {
+            values.push_back(v);
+            // 消费过程中投递的元素留给下一次popAll
+            queue.push(v + 10);
+        });
+        REQUIRE(count == 2);
+        REQUIRE(values == std::vector<int>({1, 2}));
+
+        values.clear();
+        REQUIRE(queue.popAll([&](int v) {
+            values.push_back(v);
+        }) == 2);
+        REQUIRE(values == std::vector<int>({11, 12}));
+        REQUIRE(queue.empty());
+    }
+
+    {
+        const int ProducerNum = 4;
+        const int PushNum = 100000;
+
+        MPSCQueue<std::pair<int, int>> queue;
+        std::vector<std::thread> producers;
+        for (int i = 0; i < ProducerNum; i++)
+        {
+            producers.emplace_back([&queue, i]() {
+                for (int j = 0; j < PushNum; j++)
+                {
+                    queue.push(std::make_pair(i, j));
+                }
+            });
+        }
+
+        std::vector<int> nextValues(ProducerNum, 0);
+        int total = 0;
+        bool ordered = true;
+        while (total < ProducerNum * PushNum)
+        {
+            std::pair<int, int> value;
+            if (!queue.pop(value))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            if (nextValues[value.first] != value.second)
+            {
+                ordered = false;
+            }
+            nextValues[value.first] = value.second + 1;
+            total++;
+        }
+
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+
+        REQUIRE(ordered);
+        REQUIRE(queue.empty());
+        for (const auto& v : nextValues)
+        {
+            REQUIRE(v == PushNum);
+        }
+    }
+}
+
+TEST_CASE("MPSCRingQueue are computed", "[mpsc_queue]")
+{
+    using namespace brynet::base;
+
+    {
+        MPSCRingQueue<int> queue(4);
+        REQUIRE(queue.empty());
+
+        // 超过容量的元素进入溢出队列, 顺序不变
+        for (int i = 0; i < 10; i++)
+        {
+            queue.push(int(i));
+        }
+        REQUIRE_FALSE(queue.empty());
+
+        std::vector<int> values;
+        const auto count = queue.popAll([&](int v) {
+            values.push_back(v);
+            // 消费过程中投递的元素留给下一次popAll
+            queue.push(v + 10);
+        });
+        REQUIRE(count == 10);
+        REQUIRE(values == std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+        values.clear();
+        REQUIRE(queue.popAll([&](int v) {
+            values.push_back(v);
+        }) == 10);
+        REQUIRE(values == std::vector<int>({10, 11, 12, 13, 14, 15, 16, 17, 18, 19}));
+        REQUIRE(queue.empty());
+    }
+
+    {
+        const int ProducerNum = 4;
+        const int PushNum = 100000;
+
+        // 容量很小, 频繁在环与溢出队列之间切换
+        MPSCRingQueue<std::pair<int, int>> queue(16);
+        std::vector<std::thread> producers;
+        for (int i = 0; i < ProducerNum; i++)
+        {
+            producers.emplace_back([&queue, i]() {
+                for (int j = 0; j < PushNum; j++)
+                {
+                    queue.push(std::make_pair(i, j));
+                }
+            });
+        }
+
+        std::vector<int> nextValues(ProducerNum, 0);
+        int total = 0;
+        bool ordered = true;
+        while (total < ProducerNum * PushNum)
+        {
+            const auto count = queue.popAll([&](const std::pair<int, int>& value) {
+                if (nextValues[value.first] != value.second)
+                {
+                    ordered = false;
+                }
+                nextValues[value.first] = value.second + 1;
+            });
+            if (count == 0)
+            {
+                std::this_thread::yield();
+            }
+            total += static_cast<int>(count);
+        }
+
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+
+        REQUIRE(ordered);
+        REQUIRE(queue.empty());
+        for (const auto& v : nextValues)
+        {
+            REQUIRE(v == PushNum);
+        }
+    }
+}
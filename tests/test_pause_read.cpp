@@ -0,0 +1,107 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <atomic>
+#include <brynet/net/wrapper/ConnectionBuilder.hpp>
+#include <brynet/net/wrapper/ServiceBuilder.hpp>
+#include <thread>
+
+#include "catch.hpp"
+
+static bool WaitFor(const std::function<bool()>& condition)
+{
+    for (int i = 0; i < 500 && !condition(); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return condition();
+}
+
+TEST_CASE("TcpConnection pause and resume read", "[pause_read]")
+{
+    using namespace brynet::net;
+
+    const std::string ip = "127.0.0.1";
+    const auto port = 9994;
+    const size_t sendLen = 4 * 1024 * 1024;
+
+    auto service = TcpService::Create();
+    service->startWorkerThread(1);
+
+    std::atomic<size_t> recvLen{0};
+    std::atomic<size_t> pausedRecvLen{0};
+    std::atomic_bool pauseInCallback{false};
+    std::atomic_bool paused{false};
+    std::mutex sessionGuard;
+    TcpConnection::Ptr serverSession;
+
+    wrapper::ListenerBuilder listener;
+    listener.WithService(service)
+            .WithAddr(false, ip, port)
+            .WithMaxRecvBufferSize(64 * 1024)
+            .AddEnterCallback([&](const TcpConnection::Ptr& session) {
+                auto rawSession = session.get();
+                session->setDataCallback([&, rawSession](brynet::base::BasePacketReader& reader) {
+                    REQUIRE(!paused);
+                    recvLen += reader.size();
+                    reader.consumeAll();
+                    if (pauseInCallback)
+                    {
+                        pauseInCallback = false;
+                        paused = true;
+                        pausedRecvLen = recvLen.load();
+                        rawSession->pauseRead();
+                    }
+                });
+                // 连接建立后立即暂停读取
+                paused = true;
+                session->pauseRead();
+
+                std::lock_guard<std::mutex> lck(sessionGuard);
+                serverSession = session;
+            })
+            .asyncRun();
+
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+    wrapper::ConnectionBuilder connectionBuilder;
+    auto clientSession = connectionBuilder
+                                 .WithService(service)
+                                 .WithConnector(connector)
+                                 .WithTimeout(std::chrono::seconds(2))
+                                 .WithAddr(ip, port)
+                                 .syncConnect();
+    REQUIRE(clientSession != nullptr);
+    REQUIRE(WaitFor([&]() {
+        std::lock_guard<std::mutex> lck(sessionGuard);
+        return serverSession != nullptr;
+    }));
+
+    auto msg = MakeStringMsg(std::string(sendLen, 'a'));
+    clientSession->send(msg);
+
+    // 暂停期间不会回调数据处理函数
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    REQUIRE(recvLen == 0);
+
+    paused = false;
+    serverSession->resumeRead();
+    REQUIRE(WaitFor([&]() { return recvLen == sendLen; }));
+
+    // 在数据处理函数中暂停
+    pauseInCallback = true;
+    clientSession->send(msg);
+    REQUIRE(WaitFor([&]() { return paused.load(); }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    REQUIRE(recvLen == pausedRecvLen);
+    REQUIRE(recvLen < sendLen * 2);
+
+    paused = false;
+    serverSession->resumeRead();
+    REQUIRE(WaitFor([&]() { return recvLen == sendLen * 2; }));
+
+    listener.stop();
+    clientSession->postDisConnect();
+    serverSession.reset();
+    clientSession.reset();
+    service->stopWorkerThread();
+    connector->stopWorkerThread();
+}
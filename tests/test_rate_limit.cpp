@@ -0,0 +1,221 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <atomic>
+#include <brynet/base/TokenBucket.hpp>
+#include <brynet/net/wrapper/ConnectionBuilder.hpp>
+#include <brynet/net/wrapper/ServiceBuilder.hpp>
+#include <thread>
+
+#include "catch.hpp"
+
+static bool WaitFor(const std::function<bool()>& condition)
+{
+    for (int i = 0; i < 500 && !condition(); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return condition();
+}
+
+TEST_CASE("TokenBucket refill and debt", "[rate_limit]")
+{
+    using namespace brynet::base;
+    using namespace std::chrono;
+
+    TokenBucket unlimited;
+    REQUIRE(unlimited.unlimited());
+    REQUIRE(unlimited.available() == (std::numeric_limits<size_t>::max)());
+
+    const auto now = TokenBucket::Clock::now();
+    TokenBucket bucket(1000, 100);
+    // 初始为满桶
+    REQUIRE(bucket.available(now) == 100);
+    bucket.consume(60, now);
+    REQUIRE(bucket.available(now) == 40);
+    REQUIRE(bucket.waitTime(40, now) == nanoseconds::zero());
+    // 每毫秒补充1个令牌
+    REQUIRE(bucket.available(now + milliseconds(10)) == 50);
+    REQUIRE(bucket.waitTime(50, now) == milliseconds(10));
+    // 不超过burst
+    REQUIRE(bucket.available(now + seconds(10)) == 100);
+    REQUIRE(bucket.waitTime(1000, now) == milliseconds(60));
+
+    // 超额消费形成欠账
+    bucket.consume(140, now);
+    REQUIRE(bucket.available(now) == 0);
+    REQUIRE(bucket.available(now + milliseconds(100)) == 0);
+    REQUIRE(bucket.available(now + milliseconds(110)) == 10);
+}
+
+namespace {
+
+class RateLimitServer
+{
+public:
+    RateLimitServer(const std::string& ip, int port)
+        : mService(brynet::net::TcpService::Create())
+    {
+        using namespace brynet::net;
+        mService->startWorkerThread(1);
+        mListener.WithService(mService)
+                .WithAddr(false, ip, port)
+                .WithMaxRecvBufferSize(64 * 1024)
+                .AddEnterCallback([this](const TcpConnection::Ptr& session) {
+                    auto sessionRecvLen = std::make_shared<size_t>(0);
+                    session->setDataCallback([this, sessionRecvLen](brynet::base::BasePacketReader& reader) {
+                        for (size_t i = 0; i < reader.size(); i++)
+                        {
+                            if (reader.begin()[i] != static_cast<char>((*sessionRecvLen + i) % 251))
+                            {
+                                corrupted = true;
+                            }
+                        }
+                        *sessionRecvLen += reader.size();
+                        recvLen += reader.size();
+                        reader.consumeAll();
+                    });
+                    session->setDisConnectCallback([this](const TcpConnection::Ptr&) {
+                        disconnected++;
+                    });
+                })
+                .asyncRun();
+    }
+
+    ~RateLimitServer()
+    {
+        mListener.stop();
+        mService->stopWorkerThread();
+    }
+
+    std::atomic<size_t> recvLen{0};
+    std::atomic<bool> corrupted{false};
+    std::atomic<int> disconnected{0};
+
+private:
+    brynet::net::TcpService::Ptr mService;
+    brynet::net::wrapper::ListenerBuilder mListener;
+};
+
+std::string MakePayload(size_t len)
+{
+    std::string payload(len, 0);
+    for (size_t i = 0; i < len; i++)
+    {
+        payload[i] = static_cast<char>(i % 251);
+    }
+    return payload;
+}
+
+}// namespace
+
+TEST_CASE("TcpConnection send rate limit", "[rate_limit]")
+{
+    using namespace brynet::net;
+
+    const std::string ip = "127.0.0.1";
+    const auto port = 9998;
+    const size_t rate = 1024 * 1024;
+    const size_t burst = 64 * 1024;
+    const size_t total = 512 * 1024;
+
+    RateLimitServer server(ip, port);
+    auto service = TcpService::Create();
+    service->startWorkerThread(1);
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+
+    SECTION("per connection")
+    {
+        wrapper::ConnectionBuilder connectionBuilder;
+        auto session = connectionBuilder
+                               .WithService(service)
+                               .WithConnector(connector)
+                               .WithTimeout(std::chrono::seconds(2))
+                               .WithAddr(ip, port)
+                               .syncConnect();
+        REQUIRE(session != nullptr);
+        session->setSendRateLimit(rate, burst);
+
+        std::atomic<int> highCount{0};
+        session->setHighWaterCallback([&]() {
+            highCount++;
+        },
+                                      total / 2);
+
+        const auto payload = MakePayload(total);
+        const auto start = std::chrono::steady_clock::now();
+        // 分成多条消息发送, 并在发送后立即shutdown: 暂缓发送的数据不会被丢弃
+        for (size_t offset = 0; offset < total; offset += 4096)
+        {
+            session->send(payload.data() + offset, 4096);
+        }
+        session->postShutdown();
+
+        REQUIRE(WaitFor([&]() {
+            return server.disconnected == 1;
+        }));
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        REQUIRE(server.recvLen == total);
+        REQUIRE(!server.corrupted);
+        // 除去初始的burst, 其余数据按rate发送
+        REQUIRE(elapsed >= std::chrono::milliseconds((total - burst) * 1000 / rate * 9 / 10));
+        REQUIRE(elapsed < std::chrono::seconds(3));
+        // 限速期间数据积压在发送队列中
+        REQUIRE(highCount == 1);
+        session->postDisConnect();
+    }
+
+    SECTION("per service")
+    {
+        service->setSendRateLimit(rate, burst);
+
+        std::vector<TcpConnection::Ptr> sessions;
+        for (int i = 0; i < 2; i++)
+        {
+            wrapper::ConnectionBuilder connectionBuilder;
+            auto session = connectionBuilder
+                                   .WithService(service)
+                                   .WithConnector(connector)
+                                   .WithTimeout(std::chrono::seconds(2))
+                                   .WithAddr(ip, port)
+                                   .syncConnect();
+            REQUIRE(session != nullptr);
+            sessions.push_back(session);
+        }
+
+        const auto payload = MakePayload(total);
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto& session : sessions)
+        {
+            session->send(payload.data(), total / 2);
+        }
+
+        REQUIRE(WaitFor([&]() {
+            return server.recvLen == total;
+        }));
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        REQUIRE(!server.corrupted);
+        // 两个连接共用一个令牌桶
+        REQUIRE(elapsed >= std::chrono::milliseconds((total - burst) * 1000 / rate * 9 / 10));
+        REQUIRE(elapsed < std::chrono::seconds(3));
+
+        // 取消限速后立即恢复正常发送
+        service->setSendRateLimit(0, 0);
+        const auto unlimitedStart = std::chrono::steady_clock::now();
+        for (const auto& session : sessions)
+        {
+            session->send(payload.data(), total / 2);
+        }
+        REQUIRE(WaitFor([&]() {
+            return server.recvLen == total * 2;
+        }));
+        REQUIRE(std::chrono::steady_clock::now() - unlimitedStart < std::chrono::milliseconds(300));
+
+        for (const auto& session : sessions)
+        {
+            session->postDisConnect();
+        }
+    }
+
+    service->stopWorkerThread();
+    connector->stopWorkerThread();
+}
@@ -0,0 +1,154 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <atomic>
+#include <brynet/net/detail/RingQueue.hpp>
+#include <brynet/net/wrapper/ConnectionBuilder.hpp>
+#include <brynet/net/wrapper/ServiceBuilder.hpp>
+#include <memory>
+#include <thread>
+
+#include "catch.hpp"
+
+TEST_CASE("RingQueue are computed", "[ring_queue]")
+{
+    using namespace brynet::net::detail;
+
+    RingQueue<std::shared_ptr<int>> queue;
+    REQUIRE(queue.empty());
+    REQUIRE(queue.size() == 0);
+    REQUIRE(queue.headSeq() == queue.tailSeq());
+
+    // grows on demand while keeping order and sequence numbers
+    for (int i = 0; i < 100; i++)
+    {
+        queue.push_back(std::make_shared<int>(i));
+    }
+    REQUIRE(queue.size() == 100);
+    REQUIRE(*queue.front() == 0);
+    REQUIRE(*queue.back() == 99);
+    REQUIRE(*queue[10] == 10);
+    REQUIRE(*queue.atSeq(queue.headSeq() + 42) == 42);
+
+    // pop releases the value, sequence numbers of the remaining values are unchanged
+    auto value = queue.front();
+    REQUIRE(value.use_count() == 2);
+    queue.pop_front();
+    REQUIRE(value.use_count() == 1);
+    REQUIRE(queue.headSeq() == 1);
+    REQUIRE(*queue.front() == 1);
+    REQUIRE(*queue.atSeq(42) == 42);
+
+    // wraps around
+    for (int i = 100; i < 1000; i++)
+    {
+        queue.pop_front();
+        queue.push_back(std::make_shared<int>(i));
+    }
+    REQUIRE(queue.size() == 99);
+    REQUIRE(*queue.front() == 901);
+    REQUIRE(*queue.back() == 999);
+    REQUIRE(queue.tailSeq() - queue.headSeq() == 99);
+
+    queue.clear();
+    REQUIRE(queue.empty());
+    REQUIRE(queue.headSeq() == 1000);
+}
+
+TEST_CASE("TcpConnection send deep queue", "[ring_queue]")
+{
+    using namespace brynet::net;
+
+    const std::string ip = "127.0.0.1";
+    const auto port = 9995;
+
+    auto service = TcpService::Create();
+    service->startWorkerThread(1);
+
+    std::mutex recvGuard;
+    std::string recvData;
+    TcpConnection::Ptr serverSession;
+    wrapper::ListenerBuilder listener;
+    listener.WithService(service)
+            .WithAddr(false, ip, port)
+            .WithMaxRecvBufferSize(64 * 1024)
+            .AddEnterCallback([&](const TcpConnection::Ptr& session) {
+                session->setDataCallback([&](brynet::base::BasePacketReader& reader) {
+                    std::lock_guard<std::mutex> lck(recvGuard);
+                    recvData.append(reader.begin(), reader.size());
+                    reader.consumeAll();
+                });
+                // 接收方暂不读取, 让发送方积压大量消息并多次部分写入
+                session->pauseRead();
+                std::lock_guard<std::mutex> lck(recvGuard);
+                serverSession = session;
+            })
+            .asyncRun();
+
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+    wrapper::ConnectionBuilder connectionBuilder;
+    auto session = connectionBuilder
+                           .WithService(service)
+                           .WithConnector(connector)
+                           .WithTimeout(std::chrono::seconds(2))
+                           .WithAddr(ip, port)
+                           .syncConnect();
+    REQUIRE(session != nullptr);
+
+    std::string expectData;
+    std::atomic<size_t> completeCount{0};
+    const size_t msgNum = 50000;
+    for (size_t i = 0; i < msgNum; i++)
+    {
+        auto s = std::to_string(i) + ":" + std::string(i % 997, 'x') + ";";
+        expectData += s;
+        auto msg = (i % 3 == 0) ? MakeSlicesMsg({MakeStringMsg(s.substr(0, 1)), MakeStringMsg(s.substr(1))})
+                                : MakeStringMsg(std::move(s));
+        session->send(msg, [&completeCount]() {
+            completeCount++;
+        });
+    }
+
+    for (int i = 0; i < 100; i++)
+    {
+        {
+            std::lock_guard<std::mutex> lck(recvGuard);
+            if (serverSession != nullptr)
+            {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    {
+        std::lock_guard<std::mutex> lck(recvGuard);
+        REQUIRE(serverSession != nullptr);
+        serverSession->resumeRead();
+    }
+
+    for (int i = 0; i < 500; i++)
+    {
+        {
+            std::lock_guard<std::mutex> lck(recvGuard);
+            if (recvData.size() >= expectData.size())
+            {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(recvGuard);
+        REQUIRE(recvData.size() == expectData.size());
+        REQUIRE(recvData == expectData);
+        serverSession.reset();
+    }
+    REQUIRE(completeCount == msgNum);
+
+    listener.stop();
+    session->postDisConnect();
+    session.reset();
+    service->stopWorkerThread();
+    connector->stopWorkerThread();
+}
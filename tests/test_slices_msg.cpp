@@ -0,0 +1,133 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <atomic>
+#include <brynet/net/wrapper/ConnectionBuilder.hpp>
+#include <brynet/net/wrapper/ServiceBuilder.hpp>
+#include <thread>
+
+#include "catch.hpp"
+
+TEST_CASE("SlicesSendMsg iterate from offset", "[slices_msg]")
+{
+    using namespace brynet::net;
+
+    const auto msg = MakeSlicesMsg({MakeStringMsg("abc"),
+                                    MakeStringMsg(""),
+                                    MakeStringMsg("de"),
+                                    MakeStringMsg("fghi")});
+    REQUIRE(msg->size() == 9);
+    REQUIRE(msg->data() == nullptr);
+    REQUIRE(msg->asSlicesMsg() != nullptr);
+
+    for (size_t offset = 0; offset <= msg->size(); offset++)
+    {
+        std::string result;
+        msg->asSlicesMsg()->forEachSlice(offset, [&](const char* buffer, size_t len) {
+            REQUIRE(len > 0);
+            result.append(buffer, len);
+            return true;
+        });
+        REQUIRE(result == std::string("abcdefghi").substr(offset));
+    }
+
+    size_t count = 0;
+    msg->asSlicesMsg()->forEachSlice(1, [&](const char*, size_t) {
+        count++;
+        return count < 2;
+    });
+    REQUIRE(count == 2);
+}
+
+TEST_CASE("TcpConnection send slices", "[slices_msg]")
+{
+    using namespace brynet::net;
+
+    const std::string ip = "127.0.0.1";
+    const auto port = 9992;
+
+    std::string body;
+    for (size_t i = 0; i < 4 * 1024 * 1024; i++)
+    {
+        body.push_back(static_cast<char>('a' + (i * 7) % 26));
+    }
+    // 多个连接/消息共享的消息体
+    const auto sharedBody = MakeStringMsg(body);
+
+    auto service = TcpService::Create();
+    service->startWorkerThread(1);
+
+    std::mutex recvGuard;
+    std::string recvData;
+    wrapper::ListenerBuilder listener;
+    listener.WithService(service)
+            .WithAddr(false, ip, port)
+            .WithMaxRecvBufferSize(64 * 1024)
+            .AddEnterCallback([&](const TcpConnection::Ptr& session) {
+                session->setDataCallback([&](brynet::base::BasePacketReader& reader) {
+                    std::lock_guard<std::mutex> lck(recvGuard);
+                    recvData.append(reader.begin(), reader.size());
+                    reader.consumeAll();
+                });
+            })
+            .asyncRun();
+
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+    wrapper::ConnectionBuilder connectionBuilder;
+    auto session = connectionBuilder
+                           .WithService(service)
+                           .WithConnector(connector)
+                           .WithTimeout(std::chrono::seconds(2))
+                           .WithAddr(ip, port)
+                           .syncConnect();
+    REQUIRE(session != nullptr);
+
+    std::string expectData;
+    std::atomic<size_t> completeCount{0};
+    auto onComplete = [&completeCount]() {
+        completeCount++;
+    };
+
+    session->send(MakeStringMsg("head"), onComplete);
+    expectData += "head";
+    session->send(MakeSlicesMsg({MakeStringMsg("header1"), sharedBody}), onComplete);
+    expectData += "header1" + body;
+    session->send(MakeSlicesMsg({MakeStringMsg("header2"), sharedBody, MakeStringMsg("end")}), onComplete);
+    expectData += "header2" + body + "end";
+
+    // 片段数量超过单次writev的iovec上限
+    std::vector<SendableMsg::Ptr> smallSlices;
+    for (size_t i = 0; i < 3000; i++)
+    {
+        const auto s = std::to_string(i) + ",";
+        smallSlices.push_back(MakeStringMsg(s));
+        expectData += s;
+    }
+    session->send(MakeSlicesMsg(std::move(smallSlices)), onComplete);
+    session->send(MakeStringMsg("tail"), onComplete);
+    expectData += "tail";
+
+    for (int i = 0; i < 500; i++)
+    {
+        {
+            std::lock_guard<std::mutex> lck(recvGuard);
+            if (recvData.size() >= expectData.size())
+            {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(recvGuard);
+        REQUIRE(recvData.size() == expectData.size());
+        REQUIRE(recvData == expectData);
+    }
+    REQUIRE(completeCount == 5);
+
+    listener.stop();
+    session->postDisConnect();
+    session.reset();
+    service->stopWorkerThread();
+    connector->stopWorkerThread();
+}
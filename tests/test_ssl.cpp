@@ -0,0 +1,547 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <atomic>
+#include <brynet/net/wrapper/ConnectionBuilder.hpp>
+#include <brynet/net/wrapper/ServiceBuilder.hpp>
+#include <cstdio>
+#include <future>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#include "catch.hpp"
+
+#ifdef BRYNET_USE_OPENSSL
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+
+static bool WaitFor(const std::function<bool()>& condition)
+{
+    for (int i = 0; i < 500 && !condition(); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return condition();
+}
+
+// 生成自签名证书(P-256)写入certFile/keyFile
+static bool WriteSelfSignedCertificate(const std::string& certFile, const std::string& keyFile)
+{
+    EVP_PKEY* pkey = nullptr;
+    auto pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+    if (pctx == nullptr ||
+        EVP_PKEY_keygen_init(pctx) <= 0 ||
+        EVP_PKEY_CTX_set_ec_paramgen_curve_nid(pctx, NID_X9_62_prime256v1) <= 0 ||
+        EVP_PKEY_keygen(pctx, &pkey) <= 0)
+    {
+        EVP_PKEY_CTX_free(pctx);
+        return false;
+    }
+    EVP_PKEY_CTX_free(pctx);
+
+    auto x509 = X509_new();
+    ASN1_INTEGER_set(X509_get_serialNumber(x509), 1);
+    X509_gmtime_adj(X509_getm_notBefore(x509), 0);
+    X509_gmtime_adj(X509_getm_notAfter(x509), 3600);
+    X509_set_pubkey(x509, pkey);
+    auto name = X509_get_subject_name(x509);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(x509, name);
+
+    bool ok = X509_sign(x509, pkey, EVP_sha256()) > 0;
+    auto certFp = fopen(certFile.c_str(), "wb");
+    auto keyFp = fopen(keyFile.c_str(), "wb");
+    ok = ok && certFp != nullptr && keyFp != nullptr &&
+         PEM_write_X509(certFp, x509) == 1 &&
+         PEM_write_PrivateKey(keyFp, pkey, nullptr, nullptr, 0, nullptr, nullptr) == 1;
+    if (certFp != nullptr)
+    {
+        fclose(certFp);
+    }
+    if (keyFp != nullptr)
+    {
+        fclose(keyFp);
+    }
+    X509_free(x509);
+    EVP_PKEY_free(pkey);
+    return ok;
+}
+
+static brynet::net::SSLHelper::Ptr CreateServerSSLHelper()
+{
+    const std::string certFile = "test_ssl_cert.pem";
+    const std::string keyFile = "test_ssl_key.pem";
+    if (!WriteSelfSignedCertificate(certFile, keyFile))
+    {
+        return nullptr;
+    }
+    auto sslHelper = brynet::net::SSLHelper::Create();
+    if (!sslHelper->initSSL(certFile, keyFile))
+    {
+        return nullptr;
+    }
+    return sslHelper;
+}
+
+TEST_CASE("SSL connection echo with kTLS fallback", "[ssl]")
+{
+    using namespace brynet::net;
+
+    const std::string ip = "127.0.0.1";
+    const auto port = 9981;
+
+    auto sslHelper = CreateServerSSLHelper();
+    REQUIRE(sslHelper != nullptr);
+
+    auto service = TcpService::Create();
+    service->startWorkerThread(1);
+
+    wrapper::ListenerBuilder listener;
+    listener.WithService(service)
+            .WithAddr(false, ip, port)
+            .WithSSL(sslHelper)
+            .WithMaxRecvBufferSize(64 * 1024)
+            .AddEnterCallback([](const TcpConnection::Ptr& session) {
+                session->setDataCallback([session](brynet::base::BasePacketReader& reader) {
+                    session->send(reader.begin(), reader.size());
+                    reader.consumeAll();
+                });
+            })
+            .asyncRun();
+
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+
+    std::mutex recvGuard;
+    std::string recvData;
+    wrapper::ConnectionBuilder connectionBuilder;
+    auto session = connectionBuilder
+                           .WithService(service)
+                           .WithConnector(connector)
+                           .WithTimeout(std::chrono::seconds(2))
+                           .WithAddr(ip, port)
+                           .WithSSL()
+                           .AddEnterCallback([&](const TcpConnection::Ptr& session) {
+                               session->setDataCallback([&](brynet::base::BasePacketReader& reader) {
+                                   std::lock_guard<std::mutex> lck(recvGuard);
+                                   recvData.append(reader.begin(), reader.size());
+                                   reader.consumeAll();
+                               });
+                           })
+                           .syncConnect();
+    REQUIRE(session != nullptr);
+
+    // 无论内核是否支持kTLS(不支持时回退到SSL_write), 各种消息都按顺序完整送达
+    std::string expectData;
+    for (int i = 0; i < 64; i++)
+    {
+        const std::string msg(1000 + i, static_cast<char>('a' + i % 26));
+        session->send(msg);
+        expectData += msg;
+    }
+    const std::string bigMsg(300 * 1024, 'b');
+    session->send(bigMsg);
+    expectData += bigMsg;
+    session->send(MakeSlicesMsg({MakeStringMsg("slice1"), MakeStringMsg(std::string(70 * 1024, 's'))}));
+    expectData += "slice1" + std::string(70 * 1024, 's');
+
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+    std::string fileData;
+    for (size_t i = 0; i < 200 * 1024; i++)
+    {
+        fileData.push_back(static_cast<char>('a' + (i * 7) % 26));
+    }
+    auto file = tmpfile();
+    REQUIRE(file != nullptr);
+    REQUIRE(fwrite(fileData.data(), 1, fileData.size(), file) == fileData.size());
+    fflush(file);
+    session->send(MakeFileMsg(fileno(file), 10, fileData.size() - 10));
+    expectData += fileData.substr(10);
+#endif
+
+    REQUIRE(WaitFor([&]() {
+        std::lock_guard<std::mutex> lck(recvGuard);
+        return recvData.size() >= expectData.size();
+    }));
+    {
+        std::lock_guard<std::mutex> lck(recvGuard);
+        REQUIRE(recvData == expectData);
+    }
+
+    std::promise<bool> ktls;
+    session->getEventLoop()->runAsyncFunctor([&]() {
+        ktls.set_value(session->isKtlsSend());
+    });
+    const auto ktlsSend = ktls.get_future().get();
+#ifdef BRYNET_PLATFORM_LINUX
+    // 未加载tls模块时必须回退到OpenSSL加密
+    std::ifstream ulp("/proc/sys/net/ipv4/tcp_available_ulp");
+    const std::string ulps((std::istreambuf_iterator<char>(ulp)), std::istreambuf_iterator<char>());
+    if (ulps.find("tls") == std::string::npos)
+    {
+        REQUIRE(!ktlsSend);
+    }
+#else
+    REQUIRE(!ktlsSend);
+#endif
+
+    session->postDisConnect();
+    session.reset();
+    listener.stop();
+    service->stopWorkerThread();
+    connector->stopWorkerThread();
+#if defined BRYNET_PLATFORM_LINUX || defined BRYNET_PLATFORM_DARWIN
+    fclose(file);
+#endif
+}
+
+// 阻塞的OpenSSL客户端: 连接并完成一次回显, 返回本次握手是否恢复了会话.
+// session非空时尝试恢复, 完成后更新为服务端最新下发的会话(TLS 1.3的票据在握手之后下发, 读取回显时一并处理)
+static bool EchoWithSession(SSL_CTX* ctx, const std::string& ip, int port, SSL_SESSION*& session)
+{
+    const auto fd = brynet::net::base::Connect(false, ip, port);
+    REQUIRE(fd != BRYNET_INVALID_SOCKET);
+    auto ssl = SSL_new(ctx);
+    SSL_set_fd(ssl, static_cast<int>(fd));
+    if (session != nullptr)
+    {
+        SSL_set_session(ssl, session);
+    }
+    REQUIRE(SSL_connect(ssl) == 1);
+    const bool reused = SSL_session_reused(ssl) == 1;
+
+    char buf[4];
+    REQUIRE(SSL_write(ssl, "ping", 4) == 4);
+    REQUIRE(SSL_read(ssl, buf, sizeof(buf)) == 4);
+    if (session != nullptr)
+    {
+        SSL_SESSION_free(session);
+    }
+    session = SSL_get1_session(ssl);
+
+    SSL_shutdown(ssl);
+    SSL_free(ssl);
+    brynet::net::base::SocketClose(fd);
+    return reused;
+}
+
+TEST_CASE("SSL server session resumption", "[ssl]")
+{
+    using namespace brynet::net;
+
+    const std::string ip = "127.0.0.1";
+    const auto port = 9982;
+
+    auto sslHelper = CreateServerSSLHelper();
+    REQUIRE(sslHelper != nullptr);
+    sslHelper->setSessionCache(1024, std::chrono::seconds(60));
+    sslHelper->enableSessionTicket(std::chrono::seconds(3600));
+
+    auto service = TcpService::Create();
+    service->startWorkerThread(2);
+
+    wrapper::ListenerBuilder listener;
+    listener.WithService(service)
+            .WithAddr(false, ip, port)
+            .WithSSL(sslHelper)
+            .WithMaxRecvBufferSize(1024)
+            .AddEnterCallback([](const TcpConnection::Ptr& session) {
+                session->setDataCallback([session](brynet::base::BasePacketReader& reader) {
+                    session->send(reader.begin(), reader.size());
+                    reader.consumeAll();
+                });
+            })
+            .asyncRun();
+
+    SECTION("TLS 1.3 session ticket with rotating keys")
+    {
+        auto ctx = SSL_CTX_new(TLS_client_method());
+        SSL_SESSION* session = nullptr;
+
+        REQUIRE(!EchoWithSession(ctx, ip, port, session));
+        REQUIRE(SSL_SESSION_get_protocol_version(session) == TLS1_3_VERSION);
+        REQUIRE(EchoWithSession(ctx, ip, port, session));
+        // 上一个密钥签发的票据仍可恢复, 并换发新密钥签发的票据
+        sslHelper->rotateSessionTicketKey();
+        REQUIRE(EchoWithSession(ctx, ip, port, session));
+        // 超过两个周期的票据失效
+        sslHelper->rotateSessionTicketKey();
+        sslHelper->rotateSessionTicketKey();
+        REQUIRE(!EchoWithSession(ctx, ip, port, session));
+        REQUIRE(EchoWithSession(ctx, ip, port, session));
+
+        REQUIRE(sslHelper->getFullHandshakeCount() == 2);
+        REQUIRE(sslHelper->getResumedHandshakeCount() == 3);
+
+        SSL_SESSION_free(session);
+        SSL_CTX_free(ctx);
+    }
+
+    SECTION("TLS 1.2 server session cache")
+    {
+        auto ctx = SSL_CTX_new(TLS_client_method());
+        SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+        SSL_SESSION* session = nullptr;
+
+        REQUIRE(!EchoWithSession(ctx, ip, port, session));
+        REQUIRE(EchoWithSession(ctx, ip, port, session));
+        REQUIRE(EchoWithSession(ctx, ip, port, session));
+
+        // 关闭会话缓存后无法以session id恢复
+        sslHelper->setSessionCache(0, std::chrono::seconds(60));
+        REQUIRE(!EchoWithSession(ctx, ip, port, session));
+
+        REQUIRE(sslHelper->getFullHandshakeCount() == 2);
+        REQUIRE(sslHelper->getResumedHandshakeCount() == 2);
+
+        SSL_SESSION_free(session);
+        SSL_CTX_free(ctx);
+    }
+
+    listener.stop();
+    service->stopWorkerThread();
+}
+
+struct ServerNameRecorder
+{
+    std::mutex guard;
+    std::vector<std::string> names;
+
+    static int Callback(SSL* ssl, int*, void* arg)
+    {
+        auto recorder = static_cast<ServerNameRecorder*>(arg);
+        const auto name = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+        std::lock_guard<std::mutex> lck(recorder->guard);
+        recorder->names.push_back(name == nullptr ? "" : name);
+        return SSL_TLSEXT_ERR_OK;
+    }
+};
+
+TEST_CASE("SSL shared client context with session reuse", "[ssl]")
+{
+    using namespace brynet::net;
+
+    const std::string ip = "127.0.0.1";
+    const auto port = 9983;
+
+    auto serverSSLHelper = CreateServerSSLHelper();
+    REQUIRE(serverSSLHelper != nullptr);
+    serverSSLHelper->enableSessionTicket(std::chrono::seconds(3600));
+
+    auto service = TcpService::Create();
+    service->startWorkerThread(2);
+
+    wrapper::ListenerBuilder listener;
+    listener.WithService(service)
+            .WithAddr(false, ip, port)
+            .WithSSL(serverSSLHelper)
+            .WithMaxRecvBufferSize(1024)
+            .AddEnterCallback([](const TcpConnection::Ptr& session) {
+                session->setDataCallback([session](brynet::base::BasePacketReader& reader) {
+                    session->send(reader.begin(), reader.size());
+                    reader.consumeAll();
+                });
+            })
+            .asyncRun();
+    // 记录客户端发送的SNI
+    ServerNameRecorder serverNames;
+    SSL_CTX_set_tlsext_servername_callback(serverSSLHelper->getOpenSSLCTX(), ServerNameRecorder::Callback);
+    SSL_CTX_set_tlsext_servername_arg(serverSSLHelper->getOpenSSLCTX(), &serverNames);
+
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+
+    // 连接并完成一次回显, 返回是否连接成功(握手失败时连接被关闭)
+    auto echoOnce = [&](const SSLHelper::Ptr& clientSSLHelper, const std::string& serverName) {
+        auto echoed = std::make_shared<std::promise<bool>>();
+        wrapper::ConnectionBuilder connectionBuilder;
+        auto session = connectionBuilder
+                               .WithService(service)
+                               .WithConnector(connector)
+                               .WithTimeout(std::chrono::seconds(2))
+                               .WithAddr(ip, port)
+                               .WithSSL(clientSSLHelper, serverName)
+                               .AddEnterCallback([echoed](const TcpConnection::Ptr& session) {
+                                   session->setDataCallback([echoed](brynet::base::BasePacketReader& reader) {
+                                       reader.consumeAll();
+                                       echoed->set_value(true);
+                                   });
+                                   session->setDisConnectCallback([echoed](const TcpConnection::Ptr&) {
+                                       try
+                                       {
+                                           echoed->set_value(false);
+                                       }
+                                       catch (const std::future_error&)
+                                       {
+                                       }
+                                   });
+                               })
+                               .syncConnect();
+        REQUIRE(session != nullptr);
+        session->send("ping", 4);
+        auto result = echoed->get_future();
+        REQUIRE(result.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+        session->postDisConnect();
+        return result.get();
+    };
+
+    SECTION("session reuse and SNI")
+    {
+        auto clientSSLHelper = SSLHelper::Create();
+        REQUIRE(clientSSLHelper->initClientSSL());
+
+        REQUIRE(echoOnce(clientSSLHelper, "localhost"));
+        REQUIRE(echoOnce(clientSSLHelper, "localhost"));
+        REQUIRE(echoOnce(clientSSLHelper, "localhost"));
+        // 不同的主机名使用不同的会话
+        REQUIRE(echoOnce(clientSSLHelper, ""));
+
+        REQUIRE(clientSSLHelper->getFullHandshakeCount() == 2);
+        REQUIRE(clientSSLHelper->getResumedHandshakeCount() == 2);
+        REQUIRE(serverSSLHelper->getFullHandshakeCount() == 2);
+        REQUIRE(serverSSLHelper->getResumedHandshakeCount() == 2);
+
+        std::lock_guard<std::mutex> lck(serverNames.guard);
+        REQUIRE(serverNames.names == std::vector<std::string>{"localhost", "localhost", "localhost", ""});
+    }
+
+    SECTION("client session cache bound")
+    {
+        auto clientSSLHelper = SSLHelper::Create();
+        REQUIRE(clientSSLHelper->initClientSSL());
+        clientSSLHelper->setClientSessionCacheSize(1);
+
+        REQUIRE(echoOnce(clientSSLHelper, "localhost"));
+        REQUIRE(WaitFor([&]() { return clientSSLHelper->getClientSessionNum() == 1; }));
+        // 另一个上游的会话替换掉最早的会话
+        REQUIRE(echoOnce(clientSSLHelper, ""));
+        REQUIRE(echoOnce(clientSSLHelper, "localhost"));
+        REQUIRE(echoOnce(clientSSLHelper, "localhost"));
+        REQUIRE(clientSSLHelper->getClientSessionNum() == 1);
+        REQUIRE(clientSSLHelper->getFullHandshakeCount() == 3);
+        REQUIRE(clientSSLHelper->getResumedHandshakeCount() == 1);
+
+        // 不保存会话时每次都是完整握手
+        clientSSLHelper->setClientSessionCacheSize(0);
+        REQUIRE(clientSSLHelper->getClientSessionNum() == 0);
+        REQUIRE(echoOnce(clientSSLHelper, "localhost"));
+        REQUIRE(echoOnce(clientSSLHelper, "localhost"));
+        REQUIRE(clientSSLHelper->getClientSessionNum() == 0);
+        REQUIRE(clientSSLHelper->getFullHandshakeCount() == 5);
+    }
+
+    SECTION("peer verification")
+    {
+        auto clientSSLHelper = SSLHelper::Create();
+        REQUIRE(clientSSLHelper->initClientSSL(true, "test_ssl_cert.pem"));
+
+        REQUIRE(echoOnce(clientSSLHelper, "localhost"));
+        // 证书中的主机名不匹配
+        REQUIRE(!echoOnce(clientSSLHelper, "example.com"));
+        REQUIRE(clientSSLHelper->getFullHandshakeCount() == 1);
+
+        auto untrusted = SSLHelper::Create();
+        REQUIRE(untrusted->initClientSSL(true, "test_ssl_key.pem") == false);
+    }
+
+    listener.stop();
+    service->stopWorkerThread();
+    connector->stopWorkerThread();
+}
+TEST_CASE("SSL rate limited send retries after WANT_WRITE", "[ssl]")
+{
+    using namespace brynet::net;
+
+    const std::string ip = "127.0.0.1";
+    const auto port = 9984;
+
+    auto sslHelper = CreateServerSSLHelper();
+    REQUIRE(sslHelper != nullptr);
+
+    auto service = TcpService::Create();
+    service->startWorkerThread(1);
+
+    // 服务端先暂停读取, 让客户端的socket发送缓冲区写满
+    std::promise<TcpConnection::Ptr> serverSession;
+    std::mutex recvGuard;
+    std::string recvData;
+    wrapper::ListenerBuilder listener;
+    listener.WithService(service)
+            .WithAddr(false, ip, port)
+            .WithSSL(sslHelper)
+            .WithMaxRecvBufferSize(64 * 1024)
+            .AddEnterCallback([&](const TcpConnection::Ptr& session) {
+                session->pauseRead();
+                session->setDataCallback([&](brynet::base::BasePacketReader& reader) {
+                    std::lock_guard<std::mutex> lck(recvGuard);
+                    recvData.append(reader.begin(), reader.size());
+                    reader.consumeAll();
+                });
+                serverSession.set_value(session);
+            })
+            .asyncRun();
+
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+
+    std::atomic_bool closed{false};
+    wrapper::ConnectionBuilder connectionBuilder;
+    auto session = connectionBuilder
+                           .WithService(service)
+                           .WithConnector(connector)
+                           .WithTimeout(std::chrono::seconds(2))
+                           .WithAddr(ip, port)
+                           .WithSSL()
+                           .AddEnterCallback([&](const TcpConnection::Ptr& session) {
+                               session->setDisConnectCallback([&](const TcpConnection::Ptr&) {
+                                   closed = true;
+                               });
+                           })
+                           .syncConnect();
+    REQUIRE(session != nullptr);
+    auto peer = serverSession.get_future().get();
+
+    std::string expectData;
+    for (size_t i = 0; i < 16 * 1024 * 1024; i++)
+    {
+        expectData.push_back(static_cast<char>('a' + (i * 7) % 26));
+    }
+    session->setSendRateLimit(64 * 1024 * 1024, 1024 * 1024);
+    session->send(expectData);
+
+    // 发送停滞: SSL_write已返回WANT_WRITE
+    size_t lastPending = 0;
+    REQUIRE(WaitFor([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        const auto pending = session->getPendingSendBytes();
+        const auto stalled = pending > 0 && pending == lastPending;
+        lastPending = pending;
+        return stalled;
+    }));
+
+    // 令牌上限小于未完成的SSL_write长度, 重试仍须原样写出
+    session->setSendRateLimit(64 * 1024 * 1024, 1024);
+    peer->resumeRead();
+
+    REQUIRE(WaitFor([&]() {
+        std::lock_guard<std::mutex> lck(recvGuard);
+        return recvData.size() >= expectData.size() || closed;
+    }));
+    REQUIRE(!closed);
+    {
+        std::lock_guard<std::mutex> lck(recvGuard);
+        REQUIRE(recvData == expectData);
+    }
+
+    session->postDisConnect();
+    session.reset();
+    peer.reset();
+    listener.stop();
+    service->stopWorkerThread();
+    connector->stopWorkerThread();
+}
+#else
+TEST_CASE("SSL disabled", "[ssl]")
+{
+}
+#endif
@@ -2,6 +2,9 @@
 #include <brynet/base/Timer.hpp>
 #include <chrono>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "catch.hpp"
 
@@ -50,3 +53,179 @@ TEST_CASE("Timer are computed", "[timer]")
 
     REQUIRE(upvalue == 2);
 }
+
+TEST_CASE("Timer wheel are computed", "[timer]")
+{
+    using namespace brynet::base;
+
+    auto timerMgr = std::make_shared<TimerMgr>(TimerMgr::Mode::Wheel);
+    REQUIRE(timerMgr->isEmpty());
+    // bind the wheel to this thread, cancel() in this thread removes the timer immediately
+    timerMgr->schedule();
+
+    int upvalue = 0;
+    auto timer = timerMgr->addTimer(std::chrono::milliseconds(10), [&upvalue]() {
+        upvalue++;
+    });
+    REQUIRE_FALSE(timerMgr->isEmpty());
+    REQUIRE_FALSE(timerMgr->nearLeftTime() > std::chrono::milliseconds(11));
+    timer.lock()->cancel();
+    REQUIRE(timerMgr->isEmpty());
+    REQUIRE(timer.expired());
+
+    std::vector<int> order;
+    timerMgr->addTimer(std::chrono::milliseconds(300), [&order]() {
+        order.push_back(300);
+    });
+    timerMgr->addTimer(std::chrono::milliseconds(5), [&order]() {
+        order.push_back(5);
+    });
+    timerMgr->addTimer(std::chrono::milliseconds(20), [&order]() {
+        order.push_back(20);
+    });
+
+    const auto startTime = std::chrono::steady_clock::now();
+    while (!timerMgr->isEmpty())
+    {
+        std::this_thread::sleep_for(timerMgr->nearLeftTime());
+        timerMgr->schedule();
+    }
+    REQUIRE(std::chrono::steady_clock::now() - startTime >= std::chrono::milliseconds(300));
+    REQUIRE(order == std::vector<int>({5, 20, 300}));
+    REQUIRE(upvalue == 0);
+
+    // 在回调中取消另一个尚未触发的定时器
+    Timer::WeakPtr other;
+    timerMgr->addTimer(std::chrono::milliseconds(1), [&other, &upvalue]() {
+        upvalue++;
+        auto t = other.lock();
+        if (t != nullptr)
+        {
+            t->cancel();
+        }
+    });
+    other = timerMgr->addTimer(std::chrono::milliseconds(2), [&upvalue]() {
+        upvalue++;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    timerMgr->schedule();
+    REQUIRE(timerMgr->isEmpty());
+    REQUIRE(upvalue == 1);
+}
+
+TEST_CASE("Timer near expire time are computed", "[timer]")
+{
+    using namespace brynet::base;
+
+    auto timerMgr = std::make_shared<TimerMgr>();
+    REQUIRE(timerMgr->nearExpireTime() == std::chrono::steady_clock::time_point::max());
+
+    auto timer = timerMgr->addTimer(std::chrono::microseconds(200), []() {
+    });
+    auto expireTime = timer.lock()->getStartTime() + timer.lock()->getLastTime();
+    timerMgr->addTimer(std::chrono::seconds(1), []() {
+    });
+    REQUIRE(timerMgr->nearExpireTime() == expireTime);
+    REQUIRE_FALSE(timerMgr->nearLeftTime() > std::chrono::microseconds(200));
+}
+
+TEST_CASE("Timer wheel cross thread cancel are computed", "[timer]")
+{
+    using namespace brynet::base;
+
+    std::mutex posted_guard;
+    std::vector<Timer::Callback> posted;
+    auto timerMgr = std::make_shared<TimerMgr>(TimerMgr::Mode::Wheel);
+    timerMgr->setCancelPoster([&](Timer::Callback&& f) {
+        std::lock_guard<std::mutex> lck(posted_guard);
+        posted.push_back(std::move(f));
+    });
+    timerMgr->schedule();
+
+    int upvalue = 0;
+    auto timer = timerMgr->addTimer(std::chrono::hours(1), [&upvalue]() {
+        upvalue++;
+    });
+    std::thread([timer]() {
+        timer.lock()->cancel();
+    }).join();
+
+    // 移除操作投递到所属线程执行
+    REQUIRE(posted.size() == 1);
+    REQUIRE_FALSE(timerMgr->isEmpty());
+    for (auto& f : posted)
+    {
+        f();
+    }
+    posted.clear();
+    REQUIRE(timerMgr->isEmpty());
+    REQUIRE(timer.expired());
+    REQUIRE(upvalue == 0);
+
+    // 投递的移除执行前定时器已经到期
+    timer = timerMgr->addTimer(std::chrono::milliseconds(1), [&upvalue]() {
+        upvalue++;
+    });
+    std::thread([timer]() {
+        timer.lock()->cancel();
+    }).join();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    timerMgr->schedule();
+    REQUIRE(timerMgr->isEmpty());
+    for (auto& f : posted)
+    {
+        f();
+    }
+    REQUIRE(timerMgr->isEmpty());
+    REQUIRE(upvalue == 0);
+}
+
+TEST_CASE("Timer wheel sub tick timer are computed", "[timer]")
+{
+    using namespace brynet::base;
+
+    auto timerMgr = std::make_shared<TimerMgr>(TimerMgr::Mode::Wheel);
+    timerMgr->addTimer(std::chrono::seconds(1), []() {
+    });
+
+    // 不足一个刻度的定时器不取整, 按原始到期时间触发
+    int upvalue = 0;
+    auto timer = timerMgr->addTimer(std::chrono::microseconds(200), [&upvalue]() {
+        upvalue++;
+    });
+    const auto expireTime = timer.lock()->getStartTime() + timer.lock()->getLastTime();
+    REQUIRE(timerMgr->nearExpireTime() == expireTime);
+
+    std::this_thread::sleep_until(expireTime);
+    timerMgr->schedule();
+    REQUIRE(upvalue == 1);
+    REQUIRE_FALSE(timerMgr->isEmpty());
+}
+
+TEST_CASE("Timer wheel high level near expire time are computed", "[timer]")
+{
+    using namespace brynet::base;
+
+    auto timerMgr = std::make_shared<TimerMgr>(TimerMgr::Mode::Wheel);
+
+    // 只有高层定时器时, 按nearExpireTime休眠也不会错过级联与到期
+    for (const auto timeout : {std::chrono::milliseconds(300), std::chrono::milliseconds(700)})
+    {
+        bool fired = false;
+        auto timer = timerMgr->addTimer(timeout, [&fired]() {
+            fired = true;
+        });
+        const auto expireTime = timer.lock()->getStartTime() + timer.lock()->getLastTime();
+
+        while (!fired)
+        {
+            const auto nearTime = timerMgr->nearExpireTime();
+            REQUIRE(nearTime <= expireTime + std::chrono::milliseconds(1));
+            std::this_thread::sleep_until(nearTime);
+            timerMgr->schedule();
+        }
+        REQUIRE(std::chrono::steady_clock::now() >= expireTime);
+        REQUIRE(std::chrono::steady_clock::now() < expireTime + std::chrono::milliseconds(100));
+        REQUIRE(timerMgr->isEmpty());
+    }
+}
@@ -0,0 +1,127 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <atomic>
+#include <brynet/net/wrapper/ConnectionBuilder.hpp>
+#include <brynet/net/wrapper/ServiceBuilder.hpp>
+#include <future>
+#include <thread>
+
+#include "catch.hpp"
+
+static bool WaitFor(const std::function<bool()>& condition)
+{
+    for (int i = 0; i < 500 && !condition(); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return condition();
+}
+
+TEST_CASE("TcpConnection high and low water callback", "[water_mark]")
+{
+    using namespace brynet::net;
+
+    const std::string ip = "127.0.0.1";
+    const auto port = 9996;
+    const size_t highWater = 1024 * 1024;
+    const size_t lowWater = 64 * 1024;
+
+    auto service = TcpService::Create();
+    service->startWorkerThread(1);
+
+    std::atomic<size_t> recvLen{0};
+    std::mutex sessionGuard;
+    TcpConnection::Ptr serverSession;
+    wrapper::ListenerBuilder listener;
+    listener.WithService(service)
+            .WithAddr(false, ip, port)
+            .WithMaxRecvBufferSize(64 * 1024)
+            .AddEnterCallback([&](const TcpConnection::Ptr& session) {
+                session->setDataCallback([&](brynet::base::BasePacketReader& reader) {
+                    recvLen += reader.size();
+                    reader.consumeAll();
+                });
+                // 接收方暂不读取, 使发送方积压
+                session->pauseRead();
+                std::lock_guard<std::mutex> lck(sessionGuard);
+                serverSession = session;
+            })
+            .asyncRun();
+
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+    wrapper::ConnectionBuilder connectionBuilder;
+    auto session = connectionBuilder
+                           .WithService(service)
+                           .WithConnector(connector)
+                           .WithTimeout(std::chrono::seconds(2))
+                           .WithAddr(ip, port)
+                           .syncConnect();
+    REQUIRE(session != nullptr);
+    REQUIRE(WaitFor([&]() {
+        std::lock_guard<std::mutex> lck(sessionGuard);
+        return serverSession != nullptr;
+    }));
+
+    std::atomic<int> highCount{0};
+    std::atomic<int> lowCount{0};
+    std::atomic<size_t> pendingAtLow{0};
+    session->setHighWaterCallback([&]() {
+        highCount++;
+    },
+                                  highWater);
+    session->setLowWaterCallback([&]() {
+        lowCount++;
+        pendingAtLow = session->getPendingSendBytes();
+    },
+                                 lowWater);
+
+    const std::string msg(16 * 1024, 'm');
+    const size_t msgNum = 1024;
+    auto sendAll = [&]() {
+        std::promise<void> sended;
+        session->getEventLoop()->runAsyncFunctor([&]() {
+            for (size_t i = 0; i < msgNum; i++)
+            {
+                session->send(msg);
+            }
+            sended.set_value();
+        });
+        sended.get_future().wait();
+    };
+
+    for (int round = 1; round <= 2; round++)
+    {
+        sendAll();
+        // 超过高水位后只回调一次
+        REQUIRE(highCount == round);
+        REQUIRE(lowCount == round - 1);
+        REQUIRE(session->getPendingSendBytes() > highWater);
+
+        {
+            std::lock_guard<std::mutex> lck(sessionGuard);
+            serverSession->resumeRead();
+        }
+        REQUIRE(WaitFor([&]() {
+            return recvLen == round * msgNum * msg.size();
+        }));
+        REQUIRE(WaitFor([&]() {
+            return lowCount == round;
+        }));
+        REQUIRE(pendingAtLow <= lowWater);
+        REQUIRE(session->getPendingSendBytes() == 0);
+        REQUIRE(highCount == round);
+
+        std::lock_guard<std::mutex> lck(sessionGuard);
+        serverSession->pauseRead();
+    }
+
+    listener.stop();
+    session->postDisConnect();
+    session.reset();
+    {
+        std::lock_guard<std::mutex> lck(sessionGuard);
+        serverSession.reset();
+    }
+    service->stopWorkerThread();
+    connector->stopWorkerThread();
+}
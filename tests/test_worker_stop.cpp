@@ -0,0 +1,60 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <brynet/net/TcpService.hpp>
+#include <chrono>
+#include <future>
+#include <thread>
+
+#include "catch.hpp"
+
+// 在单独线程中停止工作线程, 超时返回false(停止线程被遗弃, 避免测试永久阻塞)
+static bool StopWithin(const brynet::net::TcpService::Ptr& service, std::chrono::seconds timeout)
+{
+    auto stopped = std::make_shared<std::promise<void>>();
+    auto future = stopped->get_future();
+    std::thread([service, stopped]() {
+        service->stopWorkerThread();
+        stopped->set_value();
+    }).detach();
+    return future.wait_for(timeout) == std::future_status::ready;
+}
+
+TEST_CASE("TcpService stops while busy polling", "[worker_stop]")
+{
+    using namespace brynet::net;
+
+    for (const auto useIoUring : {false, true})
+    {
+        EventLoopOption option;
+        option.useIoUring = useIoUring;
+        // 空闲时第一次轮询持续1秒, 停止请求几乎总是落在轮询期间
+        option.busyPollTime = std::chrono::seconds(1);
+
+        // 没有帧回调, 工作线程只能由wakeup唤醒
+        auto service = TcpService::Create();
+        service->startWorkerThread(1, nullptr, option);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        REQUIRE(StopWithin(service, std::chrono::seconds(5)));
+    }
+}
+
+TEST_CASE("TcpService stops idle workers without frame callback", "[worker_stop]")
+{
+    using namespace brynet::net;
+
+    for (const auto useIoUring : {false, true})
+    {
+        EventLoopOption option;
+        option.useIoUring = useIoUring;
+
+        // Linux下工作线程无限期阻塞等待, 停止只依靠wakeup; 多次启停覆盖停止请求落在不同阶段的情况
+        for (int i = 0; i < 50; i++)
+        {
+            auto service = TcpService::Create();
+            service->startWorkerThread(2, nullptr, option);
+            std::this_thread::sleep_for(std::chrono::milliseconds(i % 5));
+
+            REQUIRE(StopWithin(service, std::chrono::seconds(5)));
+        }
+    }
+}
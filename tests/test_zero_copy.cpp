@@ -0,0 +1,97 @@
+#define CATCH_CONFIG_MAIN// This tells Catch to provide a main() - only do this in one cpp file
+#include <atomic>
+#include <brynet/net/wrapper/ConnectionBuilder.hpp>
+#include <brynet/net/wrapper/ServiceBuilder.hpp>
+#include <thread>
+
+#include "catch.hpp"
+
+TEST_CASE("TcpConnection zero copy send", "[zero_copy]")
+{
+#ifdef BRYNET_PLATFORM_LINUX
+    using namespace brynet::net;
+
+    const std::string ip = "127.0.0.1";
+    const auto port = 9992;
+    const size_t msgNum = 32;
+    const size_t bigMsgLen = 256 * 1024;
+
+    auto service = TcpService::Create();
+    service->startWorkerThread(1);
+
+    std::mutex recvGuard;
+    std::string recvData;
+    wrapper::ListenerBuilder listener;
+    listener.WithService(service)
+            .WithAddr(false, ip, port)
+            .WithMaxRecvBufferSize(64 * 1024)
+            .AddEnterCallback([&](const TcpConnection::Ptr& session) {
+                session->setDataCallback([&](brynet::base::BasePacketReader& reader) {
+                    std::lock_guard<std::mutex> lck(recvGuard);
+                    recvData.append(reader.begin(), reader.size());
+                    reader.consumeAll();
+                });
+            })
+            .asyncRun();
+
+    auto connector = AsyncConnector::Create();
+    connector->startWorkerThread();
+    wrapper::ConnectionBuilder connectionBuilder;
+    auto session = connectionBuilder
+                           .WithService(service)
+                           .WithConnector(connector)
+                           .WithTimeout(std::chrono::seconds(2))
+                           .WithAddr(ip, port)
+                           .syncConnect();
+    REQUIRE(session != nullptr);
+    session->setZeroCopyThreshold(64 * 1024);
+
+    // 大消息走零拷贝, 小消息普通发送, 发送完成回调仍然按发送顺序调用
+    std::string expectData;
+    std::mutex completeGuard;
+    std::vector<size_t> completeOrder;
+    for (size_t i = 0; i < msgNum; i++)
+    {
+        const auto len = (i % 4 == 3) ? 16 : bigMsgLen;
+        auto data = std::string(len, static_cast<char>('a' + i % 26));
+        expectData += data;
+        session->send(MakeStringMsg(std::move(data)), [&completeGuard, &completeOrder, i]() {
+            std::lock_guard<std::mutex> lck(completeGuard);
+            completeOrder.push_back(i);
+        });
+    }
+
+    for (int i = 0; i < 500; i++)
+    {
+        {
+            std::lock_guard<std::mutex> lck(completeGuard);
+            std::lock_guard<std::mutex> lck2(recvGuard);
+            if (completeOrder.size() == msgNum && recvData.size() == expectData.size())
+            {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(completeGuard);
+        REQUIRE(completeOrder.size() == msgNum);
+        for (size_t i = 0; i < msgNum; i++)
+        {
+            REQUIRE(completeOrder[i] == i);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lck(recvGuard);
+        REQUIRE(recvData == expectData);
+    }
+    REQUIRE(service->getEventLoops().front()->getPendingSendBytes() == 0);
+
+    listener.stop();
+    session->postDisConnect();
+    session.reset();
+    service->stopWorkerThread();
+    connector->stopWorkerThread();
+#endif
+}